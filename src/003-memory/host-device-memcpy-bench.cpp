@@ -1,48 +1,172 @@
+#include <algorithm>
 #include <iostream>
 #include <sycl/sycl.hpp>
 
+#include "common/bench-driver.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/expression.hpp"
 #include "cpp-bench-utils/utils.hpp"
 
 template <typename T>
-void bench_memcpy(sycl::queue& q, size_t size)
+void bench_memcpy(bench::Driver& driver, size_t size)
 {
     using namespace cbu;
 
     std::vector<T> host_vec(size);
     random_fill(host_vec);
 
-    auto* device_vec = sycl::malloc_device<T>(size, q);
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    auto* device_vec = pool.malloc_device<T>(size, q);
+
+    // page-locked host memory, the copy engine reads/writes it directly without a staging buffer
+    auto* pinned_vec = pool.malloc_host<T>(size, q);
+    std::copy(host_vec.begin(), host_vec.end(), pinned_vec);
 
     BenchmarkOptions opt{
         .total_mem_bytes = size * sizeof(T),
     };
 
     float size_mb = static_cast<float>(size * sizeof(T)) / (1024.0f * 1024.0f);
-    std::cout << "\n========== Data size: " << size_mb << " MB ==========\n";
+    driver.section("Data size: " + std::to_string(size_mb) + " MB");
+
+    driver.run("bench_memcpy - host to device", [&]()
+    {
+        bench::track(q.memcpy(device_vec, host_vec.data(), size * sizeof(T))).wait();
+        q.wait();
+    }, opt);
 
-    std::cout << "\nbench_memcpy - host to device:\n";
-    benchmark_func_by_time(10, [&]()
+    driver.run("bench_memcpy - device to host", [&]()
     {
-        q.memcpy(device_vec, host_vec.data(), size * sizeof(T)).wait();
+        bench::track(q.memcpy(host_vec.data(), device_vec, size * sizeof(T))).wait();
         q.wait();
     }, opt);
 
-    std::cout << "\nbench_memcpy - device to host:\n";
-    benchmark_func_by_time(10, [&]()
+    driver.run("bench_memcpy - pinned host to device", [&]()
     {
-        q.memcpy(host_vec.data(), device_vec, size * sizeof(T)).wait();
+        bench::track(q.memcpy(device_vec, pinned_vec, size * sizeof(T))).wait();
         q.wait();
     }, opt);
 
-    sycl::free(device_vec, q);
+    driver.run("bench_memcpy - device to pinned host", [&]()
+    {
+        bench::track(q.memcpy(pinned_vec, device_vec, size * sizeof(T))).wait();
+        q.wait();
+    }, opt);
+
+    pool.free(pinned_vec, q);
+    pool.free(device_vec, q);
+}
+
+// c = a + b with the inputs and the result in pinned host memory, end to end.
+// serial:    copy a and b in, one kernel, copy c out, every step waits for the previous one.
+// pipelined: the buffer is cut into chunks dealt round-robin to several in-order queues, so the
+//            copy-in of one chunk overlaps the kernel and the copy-out of the others.
+template <typename T>
+void bench_pipeline(bench::Driver& driver, size_t size, const std::vector<size_t>& chunk_nums, size_t queue_num)
+{
+    using namespace cbu;
+    constexpr size_t wg_size = 256;
+    constexpr size_t sg_size = 32;
+    constexpr size_t wi_size = 4;
+    constexpr size_t chunk_align = 1024; // elements, keeps every chunk aligned for the sycl::vec loads
+
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    T* a = pool.malloc_host<T>(size, q);
+    T* b = pool.malloc_host<T>(size, q);
+    T* c = pool.malloc_host<T>(size, q);
+    T* d_a = pool.malloc_device<T>(size, q);
+    T* d_b = pool.malloc_device<T>(size, q);
+    T* d_c = pool.malloc_device<T>(size, q);
+
+    std::vector<T> host_a(size), host_b(size), c_ref(size);
+    random_fill(host_a);
+    random_fill(host_b);
+    std::copy(host_a.begin(), host_a.end(), a);
+    std::copy(host_b.begin(), host_b.end(), b);
+    for (size_t i = 0; i < size; i++)
+    {
+        c_ref[i] = host_a[i] + host_b[i];
+    }
+
+    std::vector<sycl::queue> queues;
+    for (size_t i = 0; i < queue_num; i++)
+    {
+        queues.emplace_back(q.get_context(), q.get_device(), bench::in_order_like(q));
+    }
+
+    auto add_chunk = [&](sycl::queue& cq, size_t offset, size_t count)
+    {
+        size_t bytes = count * sizeof(T);
+        bench::track(cq.memcpy(d_a + offset, a + offset, bytes));
+        bench::track(cq.memcpy(d_b + offset, b + offset, bytes));
+        assign_with_vec<wg_size, sg_size, wi_size>(cq, d_c + offset, count, expr(d_a + offset) + expr(d_b + offset));
+        bench::track(cq.memcpy(c + offset, d_c + offset, bytes));
+    };
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = size * sizeof(T) * 3,
+    };
+
+    float size_mb = static_cast<float>(size * sizeof(T)) / (1024.0f * 1024.0f);
+    driver.section("Pipeline c = a + b, data size: " + std::to_string(size_mb) + " MB, "
+        + std::to_string(queue_num) + " queues");
+
+    auto check = [&]()
+    {
+        sycl_acc_check(q, c_ref, c);
+        std::fill(c, c + size, T{0});
+    };
+
+    driver.run("pipeline - serial", [&]()
+    {
+        add_chunk(q, 0, size);
+        q.wait();
+    }, opt, check);
+    driver.baseline("pipeline - serial");
+
+    for (size_t chunk_num : chunk_nums)
+    {
+        size_t chunk = round_up(ceil_div(size, chunk_num), chunk_align);
+        float chunk_mb = static_cast<float>(chunk * sizeof(T)) / (1024.0f * 1024.0f);
+        driver.run("pipeline - " + std::to_string(chunk_num) + " chunks of " + std::to_string(chunk_mb) + " MB", [&]()
+        {
+            for (size_t i = 0, offset = 0; offset < size; i++, offset += chunk)
+            {
+                add_chunk(queues[i % queue_num], offset, std::min(chunk, size - offset));
+            }
+            for (auto& cq : queues)
+            {
+                cq.wait();
+            }
+        }, opt, check);
+    }
+
+    pool.free(a, q);
+    pool.free(b, q);
+    pool.free(c, q);
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
 }
 
 int main(int argc, char* argv[])
 {
-    sycl::queue q{cbu::gpu_selector_by_cu, sycl::property::queue::in_order()};
+    bench::Driver driver{argc, argv};
     constexpr size_t mb = 1024 * 1024;
-    for (auto size : {1 * mb, 16 * mb, 128 * mb, 1024 * mb})
+    size_t size = driver.arg("size", 0); // bytes, 0 runs the default sweep
+    std::vector<size_t> sizes = size ? std::vector<size_t>{size} : std::vector<size_t>{1 * mb, 16 * mb, 128 * mb, 1024 * mb};
+    for (auto bytes : sizes)
     {
-        bench_memcpy<float>(q, size / sizeof(float));
+        bench_memcpy<float>(driver, bytes / sizeof(float));
     }
+
+    size_t pipeline_size = driver.arg("pipeline_size", 256 * mb); // bytes per array
+    size_t chunks = driver.arg("chunks", 0); // 0 runs the default sweep
+    size_t queues = driver.arg("queues", 3);
+    std::vector<size_t> chunk_nums = chunks ? std::vector<size_t>{chunks} : std::vector<size_t>{2, 4, 8, 16, 32, 64};
+    bench_pipeline<float>(driver, pipeline_size / sizeof(float), chunk_nums, std::max<size_t>(queues, 1));
 }
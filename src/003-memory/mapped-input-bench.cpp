@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/profiling.hpp"
+#include "common/tensor-file.hpp"
+#include "common/usm-pool.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Ways to get a tensor file (common/tensor-file.hpp) onto the device without a std::vector in between.
+// --input=<file> benchmarks an existing file, otherwise a random float vector of --size bytes is
+// written to the temp directory first. The page-in of the mapping is timed once on its own; the
+// variants then run on resident pages, so they measure only the host staging and the transfer.
+
+void bench_mapped_input(bench::Driver& driver, const std::string& path)
+{
+    using namespace cbu;
+
+    bench::MappedTensor mapped{path};
+    size_t bytes = mapped.data_bytes();
+    void* data = mapped.raw_data();
+
+    float size_mb = static_cast<float>(bytes) / (1024.0f * 1024.0f);
+    driver.section("Mapped input: " + std::to_string(size_mb) + " MB");
+
+    // Pages still in the page cache only cost a minor fault here, drop the cache for a cold read.
+    auto start = std::chrono::steady_clock::now();
+    mapped.page_in();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    driver.log() << "page-in of " << path << ": " << ms << " ms, " << bytes / (ms * 1e6) << " GB/s\n";
+
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    auto* device_buf = pool.malloc_device<char>(bytes, q);
+    auto* pinned_buf = pool.malloc_host<char>(bytes, q);
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = bytes,
+    };
+
+    // q.memcpy reads the mapping like any pageable memory, through the runtime's staging buffer.
+    driver.run("mapped - mapping to device", [&]()
+    {
+        bench::track(q.memcpy(device_buf, data, bytes)).wait();
+    }, opt);
+    driver.baseline("mapped - mapping to device");
+
+    driver.run("mapped - mapping to usm host", [&]()
+    {
+        std::memcpy(pinned_buf, data, bytes);
+    }, opt);
+
+    driver.run("mapped - mapping to usm host to device", [&]()
+    {
+        std::memcpy(pinned_buf, data, bytes);
+        bench::track(q.memcpy(device_buf, pinned_buf, bytes)).wait();
+    }, opt);
+
+    driver.run("mapped - usm host to device", [&]()
+    {
+        bench::track(q.memcpy(device_buf, pinned_buf, bytes)).wait();
+    }, opt);
+
+    if (mapped.register_for_copy(q))
+    {
+        driver.run("mapped - registered mapping to device", [&]()
+        {
+            bench::track(q.memcpy(device_buf, data, bytes)).wait();
+        }, opt);
+    }
+    else
+    {
+        driver.log() << "sycl_ext_oneapi_copy_optimize not available, skipping the registered mapping\n";
+    }
+
+    pool.free(pinned_buf, q);
+    pool.free(device_buf, q);
+}
+
+int main(int argc, char* argv[])
+{
+    bench::Driver driver{argc, argv};
+    std::string input = driver.option("input", "");
+    if (!input.empty())
+    {
+        bench_mapped_input(driver, input);
+        return 0;
+    }
+
+    size_t size = driver.arg("size", 256 * 1024 * 1024); // bytes
+    std::vector<float> vec(size / sizeof(float));
+    cbu::random_fill(vec);
+    std::string path = (std::filesystem::temp_directory_path() / "learn-sycl-mapped-input.bin").string();
+    bench::write_tensor_file(path, vec);
+    vec = {};
+
+    bench_mapped_input(driver, path);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <sycl/sycl.hpp>
+
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "004-vector/reduction.hpp"
+
+// Lazy element-wise expressions over USM pointers.
+//
+// expr(ptr) wraps a device pointer. Arithmetic operators and relu/maximum/minimum/map on expressions
+// only build a tree of small value types on the host. Nothing runs until the tree is either
+//   - assigned: assign_with_vec / assign_subgroup_continue emit one kernel that evaluates the whole
+//     tree per element and stores the result, or
+//   - reduced: every node is also a reduction Transform f(i), so any strategy in reduction.hpp
+//     takes an expression with no input pointers and folds it in the same kernel.
+// So d = a * x + b; e = relu(d); sum(e) becomes sum(relu(a * x + b)), one pass over a, x and b.
+//
+// Every node provides
+//   value_type
+//   operator()(i)   element i
+//   vec<N>(i)       elements [i * N, (i + 1) * N) as a sycl::vec, the vector_add_with_vec load
+// Nodes hold only pointers and scalars, so the tree is copied into the kernel by value.
+
+template<typename E>
+concept Expression = requires { typename E::expr_tag; };
+
+// ---------------------------------------------------------------- leaves
+
+template<typename T>
+struct ExprRef {
+    using expr_tag = void;
+    using value_type = T;
+    T *ptr;
+
+    T operator()(size_t i) const { return ptr[i]; }
+
+    template<size_t N>
+    sycl::vec<T, N> vec(size_t i) const { return load_vec<N>(ptr, i); }
+};
+
+template<typename T>
+struct ExprScalar {
+    using expr_tag = void;
+    using value_type = T;
+    T value;
+
+    T operator()(size_t) const { return value; }
+
+    template<size_t N>
+    sycl::vec<T, N> vec(size_t) const { return sycl::vec<T, N>(value); }
+};
+
+// ---------------------------------------------------------------- inner nodes
+
+// Op is called with either scalars or sycl::vec, so the same functor serves both paths.
+template<typename Op, Expression E>
+struct ExprUnary {
+    using expr_tag = void;
+    using value_type = std::invoke_result_t<Op, typename E::value_type>;
+    Op op;
+    E e;
+
+    value_type operator()(size_t i) const { return op(e(i)); }
+
+    template<size_t N>
+    sycl::vec<value_type, N> vec(size_t i) const {
+        if constexpr (std::is_invocable_r_v<sycl::vec<value_type, N>, Op, sycl::vec<typename E::value_type, N> >) {
+            return op(e.template vec<N>(i));
+        } else {
+            // op only knows scalars (e.g. a user lambda passed to map), apply it per lane
+            auto x = e.template vec<N>(i);
+            sycl::vec<value_type, N> r;
+            for (size_t j = 0; j < N; j++) {
+                r[j] = op(x[j]);
+            }
+            return r;
+        }
+    }
+};
+
+template<typename Op, Expression L, Expression R>
+struct ExprBinary {
+    using expr_tag = void;
+    using value_type = std::invoke_result_t<Op, typename L::value_type, typename R::value_type>;
+    Op op;
+    L l;
+    R r;
+
+    value_type operator()(size_t i) const { return op(l(i), r(i)); }
+
+    template<size_t N>
+    sycl::vec<value_type, N> vec(size_t i) const {
+        return op(l.template vec<N>(i), r.template vec<N>(i));
+    }
+};
+
+struct ExprPlus {
+    template<typename X>
+    X operator()(const X &a, const X &b) const { return a + b; }
+};
+
+struct ExprMinus {
+    template<typename X>
+    X operator()(const X &a, const X &b) const { return a - b; }
+};
+
+struct ExprMultiplies {
+    template<typename X>
+    X operator()(const X &a, const X &b) const { return a * b; }
+};
+
+struct ExprDivides {
+    template<typename X>
+    X operator()(const X &a, const X &b) const { return a / b; }
+};
+
+struct ExprMaximum {
+    template<typename X>
+    X operator()(const X &a, const X &b) const { return sycl::max(a, b); }
+};
+
+struct ExprMinimum {
+    template<typename X>
+    X operator()(const X &a, const X &b) const { return sycl::min(a, b); }
+};
+
+struct ExprNegate {
+    template<typename X>
+    X operator()(const X &a) const { return X(0) - a; }
+};
+
+struct ExprRelu {
+    template<typename X>
+    X operator()(const X &a) const { return sycl::max(a, X(0)); }
+};
+
+// ---------------------------------------------------------------- building expressions
+
+template<typename T>
+ExprRef<T> expr(T *ptr) {
+    return {ptr};
+}
+
+// A plain number next to an expression becomes a scalar of the expression's type.
+template<typename T, typename S>
+auto as_expr(const S &s) {
+    if constexpr (Expression<S>) {
+        return s;
+    } else {
+        return ExprScalar<T>{static_cast<T>(s)};
+    }
+}
+
+template<typename A, typename B>
+concept ExprOperands = (Expression<A> && (Expression<B> || std::is_arithmetic_v<B>))
+                       || (std::is_arithmetic_v<A> && Expression<B>);
+
+template<typename A, typename B>
+using expr_value_t = typename std::conditional_t<Expression<A>, A, B>::value_type;
+
+template<typename Op, typename A, typename B>
+auto make_binary(const A &a, const B &b) {
+    using T = expr_value_t<A, B>;
+    auto l = as_expr<T>(a);
+    auto r = as_expr<T>(b);
+    return ExprBinary<Op, decltype(l), decltype(r)>{Op{}, l, r};
+}
+
+template<typename A, typename B> requires ExprOperands<A, B>
+auto operator+(const A &a, const B &b) { return make_binary<ExprPlus>(a, b); }
+
+template<typename A, typename B> requires ExprOperands<A, B>
+auto operator-(const A &a, const B &b) { return make_binary<ExprMinus>(a, b); }
+
+template<typename A, typename B> requires ExprOperands<A, B>
+auto operator*(const A &a, const B &b) { return make_binary<ExprMultiplies>(a, b); }
+
+template<typename A, typename B> requires ExprOperands<A, B>
+auto operator/(const A &a, const B &b) { return make_binary<ExprDivides>(a, b); }
+
+template<typename A, typename B> requires ExprOperands<A, B>
+auto maximum(const A &a, const B &b) { return make_binary<ExprMaximum>(a, b); }
+
+template<typename A, typename B> requires ExprOperands<A, B>
+auto minimum(const A &a, const B &b) { return make_binary<ExprMinimum>(a, b); }
+
+template<Expression E>
+auto operator-(const E &e) { return ExprUnary<ExprNegate, E>{ExprNegate{}, e}; }
+
+template<Expression E>
+auto relu(const E &e) { return ExprUnary<ExprRelu, E>{ExprRelu{}, e}; }
+
+// Any element-wise function, e.g. map(expr(a), [](float x) { return sycl::exp(x); }).
+template<Expression E, typename F>
+auto map(const E &e, F f) { return ExprUnary<F, E>{f, e}; }
+
+// ---------------------------------------------------------------- assignment
+
+// out[i] = e(i), WI_SIZE consecutive elements per work-item through sycl::vec.
+template<size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, typename T, Expression E>
+void assign_with_vec(sycl::queue &q, T *out, size_t size, E e) {
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t offset = item.get_global_linear_id();
+            if ((offset + 1) * WI_SIZE <= size) {
+                sycl::vec<T, WI_SIZE> v = e.template vec<WI_SIZE>(offset).template convert<T>();
+                v.store(offset, out);
+            } else {
+                for (size_t i = offset * WI_SIZE; i < size; i++) {
+                    out[i] = static_cast<T>(e(i));
+                }
+            }
+        }));
+}
+
+// out[i] = e(i), each sub-group covers SG_SIZE * WI_SIZE elements with unit-stride lanes.
+template<size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, typename T, Expression E>
+void assign_subgroup_continue(sycl::queue &q, T *out, size_t size, E e) {
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t wg_offset = item.get_group(0) * WG_SIZE * WI_SIZE;
+            size_t sg_offset = item.get_sub_group().get_group_id()[0] * SG_SIZE * WI_SIZE;
+            size_t wi_offset = item.get_sub_group().get_local_id()[0];
+            size_t offset = wg_offset + sg_offset + wi_offset;
+            if (wg_offset + WG_SIZE * WI_SIZE <= size) {
+                for (size_t j = 0; j < WI_SIZE * SG_SIZE; j += SG_SIZE) {
+                    out[offset + j] = static_cast<T>(e(offset + j));
+                }
+            } else {
+                // edge work-group
+                for (size_t j = 0; j < WI_SIZE * SG_SIZE && offset + j < size; j += SG_SIZE) {
+                    out[offset + j] = static_cast<T>(e(offset + j));
+                }
+            }
+        }));
+}
+
+// ---------------------------------------------------------------- fused reduction
+
+// Op over e(0..size) in one kernel; the expression is the Transform, there are no input pointers.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, Expression E>
+void reduce_expr(sycl::queue &q, ReduceWorkspace<typename Op::acc_type> ws,
+                 typename Op::acc_type *out, size_t size, E e) {
+    reduce_group_last_group<Op, WG_SIZE, SG_SIZE, WI_SIZE>(q, ws, out, size, e);
+}
+
+// Same, but the leaves are read WI_SIZE at a time through vec<WI_SIZE>, like assign_with_vec.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, Expression E>
+    requires has_atomic_combine<Op>
+void reduce_expr_vec(sycl::queue &q, typename Op::acc_type *out, size_t size, E e) {
+    using Acc = typename Op::acc_type;
+    reduce_init<Op>(q, out);
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<Acc, 1> slm{WG_SIZE / SG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t i = item.get_global_linear_id();
+
+                Acc acc_i = Op::identity();
+                if ((i + 1) * WI_SIZE <= size) {
+                    auto v = e.template vec<WI_SIZE>(i);
+                    for (size_t j = 0; j < WI_SIZE; ++j) {
+                        acc_i = Op::combine(acc_i, Acc(v[j]));
+                    }
+                } else {
+                    for (size_t j = i * WI_SIZE; j < size; j++) {
+                        acc_i = Op::combine(acc_i, Acc(e(j)));
+                    }
+                }
+
+                Acc group_acc = group_reduce<Op, WG_SIZE, SG_SIZE>(item, acc_i, slm);
+                if (item.get_group().leader()) {
+                    atomic_combine<Op>(out, group_acc);
+                }
+            });
+    }));
+
+    reduce_finalize<Op>(q, out);
+}
@@ -0,0 +1,470 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <sycl/sycl.hpp>
+
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+
+// Typed reduction engine behind vector-sum, vector-dot and vector-reduce.
+//
+// A reduction is described by two types:
+//   Op         acc_type, identity() and combine(a, b). Optional members enable faster paths:
+//              sycl_op           a SYCL function object, used by reduce_over_group and sycl::reduction
+//              atomic_combine()  required by the atomic strategies
+//              finalize()        applied to the final value, e.g. sqrt for the L2 norm
+//   Transform  f(i, x...) turns element i of the inputs into an accumulator value, e.g. a[i] * b[i]
+//
+// Every strategy takes (q, out, size, transform, inputs...) and writes one acc_type to out[0].
+// The accumulator type is independent of the input type, e.g. Sum<double> over float inputs.
+
+// ---------------------------------------------------------------- ops
+
+template<typename Acc>
+struct Sum {
+    using acc_type = Acc;
+    using sycl_op = sycl::plus<Acc>;
+
+    static Acc identity() { return Acc{0}; }
+    static Acc combine(Acc a, Acc b) { return a + b; }
+
+    template<typename Ref>
+    static void atomic_combine(Ref &ref, Acc x) { ref.fetch_add(x); }
+};
+
+template<typename Acc>
+struct Min {
+    using acc_type = Acc;
+    using sycl_op = sycl::minimum<Acc>;
+
+    static Acc identity() { return std::numeric_limits<Acc>::max(); }
+    static Acc combine(Acc a, Acc b) { return b < a ? b : a; }
+
+    template<typename Ref>
+    static void atomic_combine(Ref &ref, Acc x) { ref.fetch_min(x); }
+};
+
+template<typename Acc>
+struct Max {
+    using acc_type = Acc;
+    using sycl_op = sycl::maximum<Acc>;
+
+    static Acc identity() { return std::numeric_limits<Acc>::lowest(); }
+    static Acc combine(Acc a, Acc b) { return b > a ? b : a; }
+
+    template<typename Ref>
+    static void atomic_combine(Ref &ref, Acc x) { ref.fetch_max(x); }
+};
+
+// Use with Square: sqrt of the sum of squares.
+template<typename Acc>
+struct Norm2 : Sum<Acc> {
+    static Acc finalize(Acc x) { return sycl::sqrt(x); }
+};
+
+template<typename T>
+struct ValueIndex {
+    T value;
+    uint64_t index;
+};
+
+// First index of the largest value. There is no SYCL function object or atomic for the pair,
+// so the group strategies fall back to sub-group shifts and only non-atomic strategies apply.
+template<typename T>
+struct ArgMax {
+    using acc_type = ValueIndex<T>;
+
+    static acc_type identity() { return {std::numeric_limits<T>::lowest(), std::numeric_limits<uint64_t>::max()}; }
+
+    static acc_type combine(acc_type a, acc_type b) {
+        return b.value > a.value || (b.value == a.value && b.index < a.index) ? b : a;
+    }
+};
+
+// ---------------------------------------------------------------- transforms
+
+template<typename Acc>
+struct Identity {
+    template<typename T>
+    Acc operator()(size_t, T x) const { return Acc(x); }
+};
+
+template<typename Acc>
+struct Square {
+    template<typename T>
+    Acc operator()(size_t, T x) const {
+        Acc v(x);
+        return v * v;
+    }
+};
+
+template<typename Acc>
+struct Product {
+    template<typename T>
+    Acc operator()(size_t, T a, T b) const { return Acc(a) * Acc(b); }
+};
+
+template<typename T>
+struct WithIndex {
+    ValueIndex<T> operator()(size_t i, T x) const { return {x, i}; }
+};
+
+// ---------------------------------------------------------------- building blocks
+
+template<typename Op>
+concept has_sycl_op = requires { typename Op::sycl_op; };
+
+template<typename Op>
+concept has_finalize = requires(typename Op::acc_type x) { Op::finalize(x); };
+
+template<typename Acc>
+using global_atomic_ref = sycl::atomic_ref<Acc,
+    sycl::memory_order::relaxed,
+    sycl::memory_scope::device,
+    sycl::access::address_space::global_space>;
+
+template<typename Op>
+concept has_atomic_combine = requires(global_atomic_ref<typename Op::acc_type> &ref, typename Op::acc_type x) {
+    Op::atomic_combine(ref, x);
+};
+
+template<typename Op>
+struct Combiner {
+    typename Op::acc_type operator()(const typename Op::acc_type &a, const typename Op::acc_type &b) const {
+        return Op::combine(a, b);
+    }
+};
+
+template<size_t WI_SIZE, typename T>
+sycl::vec<T, WI_SIZE> load_vec(T *ptr, size_t i) {
+    sycl::vec<T, WI_SIZE> v;
+    v.load(i, ptr);
+    return v;
+}
+
+// Tree reduction with shifts, the result is valid in the sub-group leader.
+template<typename Op, size_t SG_SIZE>
+typename Op::acc_type sub_group_reduce(sycl::sub_group sg, typename Op::acc_type x) {
+    for (size_t offset = SG_SIZE / 2; offset > 0; offset /= 2) {
+        x = Op::combine(x, sycl::shift_group_left(sg, x, offset));
+    }
+    return x;
+}
+
+// Work-group reduction, the result is valid in the work-group leader.
+// Ops without a SYCL function object use slm with one slot per sub-group.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE>
+typename Op::acc_type group_reduce(sycl::nd_item<1> item, typename Op::acc_type x,
+                                   const sycl::local_accessor<typename Op::acc_type, 1> &slm) {
+    if constexpr (has_sycl_op<Op>) {
+        return sycl::reduce_over_group(item.get_group(), x, typename Op::sycl_op{});
+    } else {
+        constexpr size_t SG_NUM = WG_SIZE / SG_SIZE;
+        auto sg = item.get_sub_group();
+        x = sub_group_reduce<Op, SG_SIZE>(sg, x);
+        if (sg.leader()) {
+            slm[sg.get_group_linear_id()] = x;
+        }
+        sycl::group_barrier(item.get_group());
+        if (sg.get_group_linear_id() == 0) {
+            x = Op::identity();
+            for (size_t s = sg.get_local_linear_id(); s < SG_NUM; s += SG_SIZE) {
+                x = Op::combine(x, slm[s]);
+            }
+            x = sub_group_reduce<Op, SG_SIZE>(sg, x);
+        }
+        return x;
+    }
+}
+
+template<typename Op>
+void reduce_init(sycl::queue &q, typename Op::acc_type *out) {
+    bench::track(q.single_task([=]() {
+        out[0] = Op::identity();
+    }));
+}
+
+template<typename Op>
+void reduce_finalize(sycl::queue &q, typename Op::acc_type *out) {
+    if constexpr (has_finalize<Op>) {
+        bench::track(q.single_task([=]() {
+            out[0] = Op::finalize(out[0]);
+        }));
+    }
+}
+
+template<typename Op>
+typename Op::acc_type finalized(typename Op::acc_type x) {
+    if constexpr (has_finalize<Op>) {
+        return Op::finalize(x);
+    } else {
+        return x;
+    }
+}
+
+template<typename Op>
+void atomic_combine(typename Op::acc_type *out, typename Op::acc_type x) {
+    static_assert(has_atomic_combine<Op>, "Op has no atomic_combine, use a recursion or last-group strategy");
+    global_atomic_ref<typename Op::acc_type> ref(out[0]);
+    Op::atomic_combine(ref, x);
+}
+
+// ---------------------------------------------------------------- strategies
+
+template<typename Op, typename Transform, typename... In>
+void reduce_atomic(sycl::queue &q, typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    reduce_init<Op>(q, out);
+
+    bench::track(q.parallel_for(size, [=](sycl::id<1> i) {
+        atomic_combine<Op>(out, Acc(f(i, in[i]...)));
+    }));
+
+    reduce_finalize<Op>(q, out);
+}
+
+template<typename Op, typename Transform, typename... In>
+void reduce_sycl_reduction(sycl::queue &q, typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    bench::track(q.submit([&](sycl::handler &h) {
+        auto combiner = [] {
+            if constexpr (has_sycl_op<Op>) {
+                return typename Op::sycl_op{};
+            } else {
+                return Combiner<Op>{};
+            }
+        }();
+        auto red = sycl::reduction(out, Op::identity(), combiner,
+                                   sycl::property_list{sycl::property::reduction::initialize_to_identity{}});
+        h.parallel_for(size, red, [=](sycl::id<1> i, auto &acc) {
+            acc.combine(Acc(f(i, in[i]...)));
+        });
+    }));
+
+    reduce_finalize<Op>(q, out);
+}
+
+// One launch per level, each level writes one partial per work-group into a pool temporary.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, typename Transform, typename... In>
+void reduce_group_recursion(sycl::queue &q, typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    size_t group_num = ceil_div(size, WG_SIZE);
+    Acc *temp = group_num > 1 ? bench::usm_pool().malloc_device<Acc>(group_num, q) : nullptr;
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<Acc, 1> slm{WG_SIZE / SG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{WG_SIZE * group_num, WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                auto group = item.get_group();
+                size_t i = item.get_global_linear_id();
+                Acc x = i < size ? Acc(f(i, in[i]...)) : Op::identity();
+                Acc group_acc = group_reduce<Op, WG_SIZE, SG_SIZE>(item, x, slm);
+                if (group.leader()) {
+                    if (group_num > 1) {
+                        temp[group.get_group_linear_id()] = group_acc;
+                    } else {
+                        out[0] = finalized<Op>(group_acc);
+                    }
+                }
+            });
+    }));
+
+    if (group_num > 1) {
+        reduce_group_recursion<Op, WG_SIZE, SG_SIZE>(q, out, group_num, Identity<Acc>{}, temp);
+        bench::usm_pool().free(temp, q); // reused only by work queued after this level
+    }
+}
+
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, typename Transform, typename... In>
+void reduce_group_atomic_collect(sycl::queue &q, typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    reduce_init<Op>(q, out);
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<Acc, 1> slm{WG_SIZE / SG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{round_up(size, WG_SIZE), WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t i = item.get_global_linear_id();
+                Acc x = i < size ? Acc(f(i, in[i]...)) : Op::identity();
+                Acc group_acc = group_reduce<Op, WG_SIZE, SG_SIZE>(item, x, slm);
+                if (item.get_group().leader()) {
+                    atomic_combine<Op>(out, group_acc);
+                }
+            });
+    }));
+
+    reduce_finalize<Op>(q, out);
+}
+
+// Each work-item loads WI_SIZE consecutive elements of every input with sycl::vec.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, typename Transform, typename... In>
+void reduce_group_atomic_collect_vec(sycl::queue &q, typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    reduce_init<Op>(q, out);
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<Acc, 1> slm{WG_SIZE / SG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t i = item.get_global_linear_id();
+
+                Acc acc_i = Op::identity();
+                if ((i + 1) * WI_SIZE <= size) {
+                    auto vecs = std::make_tuple(load_vec<WI_SIZE>(in, i)...);
+                    for (size_t j = 0; j < WI_SIZE; ++j) {
+                        acc_i = Op::combine(acc_i, std::apply([&](auto &... v) {
+                            return Acc(f(i * WI_SIZE + j, v[j]...));
+                        }, vecs));
+                    }
+                } else {
+                    for (size_t j = i * WI_SIZE; j < size; j++) {
+                        acc_i = Op::combine(acc_i, Acc(f(j, in[j]...)));
+                    }
+                }
+
+                Acc group_acc = group_reduce<Op, WG_SIZE, SG_SIZE>(item, acc_i, slm);
+                if (item.get_group().leader()) {
+                    atomic_combine<Op>(out, group_acc);
+                }
+            });
+    }));
+
+    reduce_finalize<Op>(q, out);
+}
+
+// Each sub-group reads WI_SIZE contiguous SG_SIZE-wide rows, so every load of the sub-group is coalesced.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, typename Transform, typename... In>
+void reduce_group_atomic_collect_sg(sycl::queue &q, typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    reduce_init<Op>(q, out);
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<Acc, 1> slm{WG_SIZE / SG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t wg_offset = item.get_group(0) * WG_SIZE * WI_SIZE;
+                size_t sg_offset = item.get_sub_group().get_group_id()[0] * SG_SIZE * WI_SIZE;
+                size_t wi_offset = item.get_sub_group().get_local_id()[0];
+                size_t offset = wg_offset + wi_offset + sg_offset;
+
+                Acc acc_i = Op::identity();
+                if (wg_offset + WG_SIZE * WI_SIZE <= size) {
+                    for (size_t i = 0; i < WI_SIZE * SG_SIZE; i += SG_SIZE) {
+                        acc_i = Op::combine(acc_i, Acc(f(offset + i, in[offset + i]...)));
+                    }
+                } else {
+                    // edge work-group
+                    for (size_t i = 0; i < WI_SIZE * SG_SIZE && offset + i < size; i += SG_SIZE) {
+                        acc_i = Op::combine(acc_i, Acc(f(offset + i, in[offset + i]...)));
+                    }
+                }
+
+                Acc group_acc = group_reduce<Op, WG_SIZE, SG_SIZE>(item, acc_i, slm);
+                if (item.get_group().leader()) {
+                    atomic_combine<Op>(out, group_acc);
+                }
+            });
+    }));
+
+    reduce_finalize<Op>(q, out);
+}
+
+// Scratch for reduce_group_last_group, allocated once and reused by every call.
+template<typename Acc>
+struct ReduceWorkspace {
+    Acc *partials; // one partial per work-group
+    uint32_t *counter; // work-groups done in the running launch, back to 0 when the launch ends
+    size_t capacity; // max number of work-groups per launch
+};
+
+template<typename Acc>
+ReduceWorkspace<Acc> reduce_workspace_alloc(sycl::queue &q, size_t capacity) {
+    ReduceWorkspace<Acc> ws{
+        bench::usm_pool().malloc_device<Acc>(capacity, q),
+        bench::usm_pool().malloc_device<uint32_t>(1, q),
+        capacity
+    };
+    q.memset(ws.counter, 0, sizeof(uint32_t)).wait();
+    return ws;
+}
+
+template<typename Acc>
+void reduce_workspace_free(sycl::queue &q, ReduceWorkspace<Acc> &ws) {
+    bench::usm_pool().free(ws.partials, q);
+    bench::usm_pool().free(ws.counter, q);
+}
+
+// Single-launch reduction: a fixed number of work-groups stride over the input, each writes its
+// partial and bumps the device counter. The work-group that arrives last combines the partials,
+// writes out[0] and resets the counter, so no init kernel, atomic op or second launch is needed.
+template<typename Op, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, typename Transform, typename... In>
+void reduce_group_last_group(sycl::queue &q, ReduceWorkspace<typename Op::acc_type> ws,
+                             typename Op::acc_type *out, size_t size, Transform f, In *... in) {
+    using Acc = typename Op::acc_type;
+    size_t group_num = std::max<size_t>(1, std::min(ceil_div(size, WG_SIZE * WI_SIZE), ws.capacity));
+    Acc *partials = ws.partials;
+    uint32_t *counter = ws.counter;
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<Acc, 1> slm{WG_SIZE / SG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{group_num * WG_SIZE, WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                auto group = item.get_group();
+                size_t g_id = group.get_group_linear_id();
+                size_t l_id = item.get_local_linear_id();
+
+                // Neighbouring work-items read neighbouring elements on every step.
+                Acc acc_i = Op::identity();
+                for (size_t wg_offset = g_id * WG_SIZE * WI_SIZE; wg_offset < size;
+                     wg_offset += group_num * WG_SIZE * WI_SIZE) {
+                    if (wg_offset + WG_SIZE * WI_SIZE <= size) {
+                        for (size_t j = 0; j < WI_SIZE; j++) {
+                            size_t e = wg_offset + j * WG_SIZE + l_id;
+                            acc_i = Op::combine(acc_i, Acc(f(e, in[e]...)));
+                        }
+                    } else {
+                        // tail of the input
+                        for (size_t j = 0; j < WI_SIZE && wg_offset + j * WG_SIZE + l_id < size; j++) {
+                            size_t e = wg_offset + j * WG_SIZE + l_id;
+                            acc_i = Op::combine(acc_i, Acc(f(e, in[e]...)));
+                        }
+                    }
+                }
+
+                Acc group_acc = group_reduce<Op, WG_SIZE, SG_SIZE>(item, acc_i, slm);
+
+                // acq_rel publishes this partial with the increment and, for the last arrival,
+                // makes every other work-group's partial visible.
+                bool is_last = false;
+                if (group.leader()) {
+                    partials[g_id] = group_acc;
+                    auto done = sycl::atomic_ref<uint32_t,
+                        sycl::memory_order::acq_rel,
+                        sycl::memory_scope::device,
+                        sycl::access::address_space::global_space>(counter[0]);
+                    is_last = done.fetch_add(1) == group_num - 1;
+                }
+                if (!sycl::group_broadcast(group, is_last)) return;
+
+                sycl::atomic_fence(sycl::memory_order::acquire, sycl::memory_scope::device);
+                Acc total_i = Op::identity();
+                for (size_t p = l_id; p < group_num; p += WG_SIZE) {
+                    total_i = Op::combine(total_i, partials[p]);
+                }
+                Acc total = group_reduce<Op, WG_SIZE, SG_SIZE>(item, total_i, slm);
+                if (group.leader()) {
+                    out[0] = finalized<Op>(total);
+                    counter[0] = 0;
+                }
+            });
+    }));
+}
@@ -1,21 +1,29 @@
 #include <iostream>
 #include <sycl/sycl.hpp>
 
+#include "common/autotune.hpp"
+#include "common/bench-driver.hpp"
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
 #include "cpp-bench-utils/utils.hpp"
 
 template<typename T>
 void vector_add_ref(const std::vector<T> &a, const std::vector<T> &b, std::vector<T> &c) {
-    for (int i = 0; i < c.size(); ++i) {
-        c[i] = a[i] + b[i];
-    }
+    bench::host_parallel_for(c.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            c[i] = a[i] + b[i];
+        }
+    });
 }
 
 template<typename T>
 void vector_add_naive(sycl::queue &q, T *a, T *b, T *c, size_t size) {
-    q.parallel_for({size}, [=](sycl::id<1> idx) {
+    bench::track(q.parallel_for({size}, [=](sycl::id<1> idx) {
         size_t offset = idx.get(0);
         c[offset] = a[offset] + b[offset];
-    });
+    }));
 }
 
 template<
@@ -24,14 +32,14 @@ template<
     size_t SG_SIZE
 >
 void vector_add_nd_range(sycl::queue &q, T *a, T *b, T *c, size_t size) {
-    cbu::check_divisible(size, WG_SIZE, "Global size must be divisible by work-group size");
-
-    q.parallel_for(
-        sycl::nd_range<1>{size, WG_SIZE},
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(size, WG_SIZE), WG_SIZE},
         [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t offset = item.get_global_linear_id();
-            c[offset] = a[offset] + b[offset];
-        });
+            if (offset < size) {
+                c[offset] = a[offset] + b[offset];
+            }
+        }));
 }
 
 template<
@@ -41,16 +49,20 @@ template<
     size_t WI_SIZE
 >
 void vector_add_workitem_continue(sycl::queue &q, T *a, T *b, T *c, size_t size) {
-    cbu::check_divisible(size, WG_SIZE * WI_SIZE, "Size must be divisible by WG_SIZE * WI_SIZE");
-
-    q.parallel_for(
-        sycl::nd_range<1>{size / WI_SIZE, WG_SIZE},
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
         [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t offset = item.get_global_linear_id() * WI_SIZE;
-            for (size_t i = 0; i < WI_SIZE; i++) {
-                c[offset + i] = a[offset + i] + b[offset + i];
+            if (offset + WI_SIZE <= size) {
+                for (size_t i = 0; i < WI_SIZE; i++) {
+                    c[offset + i] = a[offset + i] + b[offset + i];
+                }
+            } else {
+                for (size_t i = offset; i < size; i++) {
+                    c[i] = a[i] + b[i];
+                }
             }
-        });
+        }));
 }
 
 template<
@@ -60,18 +72,22 @@ template<
     size_t WI_SIZE
 >
 void vector_add_with_vec(sycl::queue &q, T *a, T *b, T *c, size_t size) {
-    cbu::check_divisible(size, WG_SIZE * WI_SIZE, "Size must be divisible by WG_SIZE * WI_SIZE");
-
-    q.parallel_for(
-        sycl::nd_range<1>{size / WI_SIZE, WG_SIZE},
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
         [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t offset = item.get_global_linear_id();
-            sycl::vec<T, WI_SIZE> vec_a, vec_b;
-            vec_a.load(offset, a);
-            vec_b.load(offset, b);
-            vec_a += vec_b;
-            vec_a.store(offset, c);
-        });
+            if ((offset + 1) * WI_SIZE <= size) {
+                sycl::vec<T, WI_SIZE> vec_a, vec_b;
+                vec_a.load(offset, a);
+                vec_b.load(offset, b);
+                vec_a += vec_b;
+                vec_a.store(offset, c);
+            } else {
+                for (size_t i = offset * WI_SIZE; i < size; i++) {
+                    c[i] = a[i] + b[i];
+                }
+            }
+        }));
 }
 
 template<
@@ -81,70 +97,99 @@ template<
     size_t WI_SIZE
 >
 void vector_add_subgroup_continue(sycl::queue &q, T *a, T *b, T *c, size_t size) {
-    cbu::check_divisible(size, WG_SIZE * WI_SIZE, "Size must be divisible by WG_SIZE * WI_SIZE");
-
-    q.parallel_for(
-        sycl::nd_range<1>{size / WI_SIZE, WG_SIZE},
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
         [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t wg_offset = item.get_group(0) * WG_SIZE * WI_SIZE;
             size_t sg_offset = item.get_sub_group().get_group_id()[0] * SG_SIZE * WI_SIZE;
             size_t wi_offset = item.get_sub_group().get_local_id()[0];
             size_t offset = wg_offset + sg_offset + wi_offset;
-            for (size_t j = 0; j < WI_SIZE * SG_SIZE; j += SG_SIZE) {
-                c[offset + j] = a[offset + j] + b[offset + j];
+            if (wg_offset + WG_SIZE * WI_SIZE <= size) {
+                for (size_t j = 0; j < WI_SIZE * SG_SIZE; j += SG_SIZE) {
+                    c[offset + j] = a[offset + j] + b[offset + j];
+                }
+            } else {
+                // edge work-group
+                for (size_t j = 0; j < WI_SIZE * SG_SIZE && offset + j < size; j += SG_SIZE) {
+                    c[offset + j] = a[offset + j] + b[offset + j];
+                }
             }
-        });
+        }));
 }
 
 
-int main(int argc, char *argv[]) {
+// One section per problem size, so an aligned and a ragged size can be compared variant by variant.
+void test_vector_add(bench::Driver &driver, bench::Tuner &tuner, const std::string &name, size_t size) {
     using namespace cbu;
     using dtype = float;
     constexpr uint16_t wg_size = 256;
     constexpr uint8_t sg_size = 32;
     constexpr uint8_t wi_size = 4;
 
-    size_t secs = 10;
-    size_t size = 100 * 1024 * 1024; // 100M elements
+    driver.section(name + " size " + std::to_string(size));
 
     std::vector<dtype> a(size), b(size), c(size);
     random_fill(a);
     random_fill(b);
 
-    std::cout << "vector_add_ref:\n";
     BenchmarkOptions opt{
         .total_mem_bytes = size * sizeof(dtype) * 3,
         .total_flop = size
     };
-    benchmark_func_by_time(secs, [&] { vector_add_ref(a, b, c); }, opt);
+    driver.run_ref("vector_add_ref", [&] { vector_add_ref(a, b, c); }, opt);
 
-    sycl::queue q{gpu_selector_by_cu, sycl::property::queue::in_order()};
-    auto *d_a = sycl::malloc_device<dtype>(size, q);
-    auto *d_b = sycl::malloc_device<dtype>(size, q);
-    auto *d_c = sycl::malloc_device<dtype>(size, q);
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_a = pool.malloc_device<dtype>(size, q);
+    auto *d_b = pool.malloc_device<dtype>(size, q);
+    auto *d_c = pool.malloc_device<dtype>(size, q);
     q.memcpy(d_a, a.data(), size * sizeof(dtype)).wait();
     q.memcpy(d_b, b.data(), size * sizeof(dtype)).wait();
 
     using func_t = std::function<void(sycl::queue &, dtype *, dtype *, dtype *, size_t)>;
+
+    auto with_vec_grid = bench::make_grid<func_t>(
+        bench::values<64, 128, 256, 512>{}, bench::values<8, 16, 32>{}, bench::values<2, 4, 8>{},
+        []<size_t WG, size_t SG, size_t WI>() -> func_t { return vector_add_with_vec<dtype, WG, SG, WI>; });
+
     std::vector<std::tuple<std::string, func_t> > funcs{
         {"vector_add_naive", vector_add_naive<dtype>},
         {"vector_add_nd_range", vector_add_nd_range<dtype, wg_size, sg_size>},
         {"vector_add_workitem_continue", vector_add_workitem_continue<dtype, wg_size, sg_size, wi_size>},
         {"vector_add_with_vec", vector_add_with_vec<dtype, wg_size, sg_size, wi_size>},
         {"vector_add_subgroup_continue", vector_add_subgroup_continue<dtype, wg_size, sg_size, wi_size>},
+        {"vector_add_with_vec_tuned", tuner.dispatch("vector_add_with_vec", with_vec_grid, size)},
     };
 
-    for (auto [func_name,func]: funcs) {
-        std::cout << "\n" << func_name << ":\n";
-        q.fill(d_c, dtype{0}, size).wait();
-        benchmark_func_by_time(secs, [&]() {
-            func(q, d_a, d_b, d_c, size);
-            q.wait();
-        }, opt);
-        sycl_acc_check(q, c, d_c);
-    }
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q, d_a, d_b, d_c, size); },
+                   [&] { q.fill(d_c, dtype{0}, size).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
+}
 
-    sycl::free(d_a, q);
-    sycl::free(d_b, q);
-    sycl::free(d_c, q);
+
+int main(int argc, char *argv[]) {
+    // the widest span a work-group covers above (256 work-items x 4 elements)
+    constexpr size_t tile = 256 * 4;
+
+    bench::Driver driver{argc, argv};
+    bench::Tuner tuner{driver.flag("retune")};
+    size_t size = driver.arg("size", 100 * 1024 * 1024); // 100M elements
+
+    // The two sizes differ by less than one work-group tile, but only the ragged one has a masked edge
+    // work-group, so the difference between the two sections is what the tail handling costs.
+    // --tail=0 skips the ragged run. Below one tile there is no aligned size that is not larger than
+    // --size, so only the ragged run happens.
+    size_t aligned = size / tile * tile;
+    size_t ragged = size % tile || !aligned ? size : aligned - 1;
+    if (aligned) {
+        test_vector_add(driver, tuner, "aligned", aligned);
+    }
+    if (driver.option("tail", "1") != "0" || !aligned) {
+        test_vector_add(driver, tuner, "ragged", ragged);
+    }
 }
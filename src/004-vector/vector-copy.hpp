@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <sycl/sycl.hpp>
+
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/roofline.hpp"
+
+// dst = src, one element per work-item or WI_SIZE elements per work-item with different access patterns.
+// The naive and with_vec variants are the bandwidth probe kernels of common/roofline.hpp.
+
+template<typename T>
+void vector_copy_naive(sycl::queue &q, T *src, T *out, size_t size) {
+    bench::copy_naive(q, src, out, size);
+}
+
+template<
+    typename T,
+    size_t WG_SIZE,
+    size_t SG_SIZE
+>
+void vector_copy_nd_range(sycl::queue &q, T *src, T *out, size_t size) {
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(size, WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t offset = item.get_global_linear_id();
+            if (offset < size) {
+                out[offset] = src[offset];
+            }
+        }));
+}
+
+template<
+    typename T,
+    size_t WG_SIZE,
+    size_t SG_SIZE,
+    size_t WI_SIZE
+>
+void vector_copy_workitem_continuous(sycl::queue &q, T *src, T *out, size_t size) {
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t i = item.get_global_linear_id();
+            T *src_base = src + i * WI_SIZE;
+            T *out_base = out + i * WI_SIZE;
+            if ((i + 1) * WI_SIZE <= size) {
+                for (size_t j = 0; j < WI_SIZE; j++) {
+                    out_base[j] = src_base[j];
+                }
+            } else {
+                for (size_t j = 0; i * WI_SIZE + j < size; j++) {
+                    out_base[j] = src_base[j];
+                }
+            }
+        }));
+}
+
+template<
+    typename T,
+    size_t WG_SIZE,
+    size_t SG_SIZE,
+    size_t WI_SIZE
+>
+void vector_copy_with_vec(sycl::queue &q, T *src, T *out, size_t size) {
+    bench::copy_with_vec<T, WG_SIZE, SG_SIZE, WI_SIZE>(q, src, out, size);
+}
+
+template<
+    typename T,
+    size_t WG_SIZE,
+    size_t SG_SIZE,
+    size_t WI_SIZE
+>
+void vector_copy_subgroup_continuous(sycl::queue &q, T *src, T *out, size_t size) {
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t wg_offset = item.get_group(0) * WG_SIZE * WI_SIZE;
+            size_t sg_offset = item.get_sub_group().get_group_id()[0] * SG_SIZE * WI_SIZE;
+            size_t wi_offset = item.get_sub_group().get_local_id()[0];
+            size_t offset = wg_offset + sg_offset + wi_offset;
+
+            T *src_base = src + offset;
+            T *out_base = out + offset;
+
+            if (wg_offset + WG_SIZE * WI_SIZE <= size) {
+                for (size_t j = 0; j < WI_SIZE * SG_SIZE; j += SG_SIZE) {
+                    out_base[j] = src_base[j];
+                }
+            } else {
+                // edge work-group
+                for (size_t j = 0; j < WI_SIZE * SG_SIZE && offset + j < size; j += SG_SIZE) {
+                    out_base[j] = src_base[j];
+                }
+            }
+        }));
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/host-parallel.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/expression.hpp"
+#include "004-vector/reduction.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// d = a * x + b; e = relu(d); sum(e)
+// unfused: one kernel per step, every intermediate makes a round trip through memory
+// fused:   one kernel built from the expression tree, a, x and b are read once
+// Bandwidth is reported for the fused traffic, so the unfused variants show their effective rate.
+
+template<typename T>
+void vector_relu_axpb_ref(const std::vector<T> &a, const std::vector<T> &x, const std::vector<T> &b,
+                          std::vector<T> &e) {
+    bench::host_parallel_for(e.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            e[i] = std::max(a[i] * x[i] + b[i], T(0));
+        }
+    });
+}
+
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_relu_axpb_unfused(sycl::queue &q, T *a, T *x, T *b, T *d, T *e, size_t size) {
+    assign_with_vec<WG_SIZE, SG_SIZE, WI_SIZE>(q, d, size, expr(a) * expr(x) + expr(b));
+    assign_with_vec<WG_SIZE, SG_SIZE, WI_SIZE>(q, e, size, relu(expr(d)));
+}
+
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_relu_axpb_fused_with_vec(sycl::queue &q, T *a, T *x, T *b, T *, T *e, size_t size) {
+    assign_with_vec<WG_SIZE, SG_SIZE, WI_SIZE>(q, e, size, relu(expr(a) * expr(x) + expr(b)));
+}
+
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_relu_axpb_fused_subgroup_continue(sycl::queue &q, T *a, T *x, T *b, T *, T *e, size_t size) {
+    assign_subgroup_continue<WG_SIZE, SG_SIZE, WI_SIZE>(q, e, size, relu(expr(a) * expr(x) + expr(b)));
+}
+
+template<typename T>
+bool same_sum(T result, double expected) {
+    return std::abs(result - expected) <= 1e-3 * std::max(std::abs(expected), 1.0);
+}
+
+
+int main(int argc, char *argv[]) {
+    using namespace cbu;
+    using dtype = float;
+    constexpr size_t wg_size = 256;
+    constexpr size_t sg_size = 32;
+    constexpr size_t wi_size = 4;
+
+    bench::Driver driver{argc, argv};
+    size_t size = driver.arg("size", 64 * 1024 * 1024); // 64M elements
+
+    std::vector<dtype> a(size), x(size), b(size), e(size);
+    random_fill(a);
+    random_fill(x);
+    random_fill(b);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_a = pool.malloc_device<dtype>(size, q);
+    auto *d_x = pool.malloc_device<dtype>(size, q);
+    auto *d_b = pool.malloc_device<dtype>(size, q);
+    auto *d_d = pool.malloc_device<dtype>(size, q);
+    auto *d_e = pool.malloc_device<dtype>(size, q);
+    q.memcpy(d_a, a.data(), size * sizeof(dtype)).wait();
+    q.memcpy(d_x, x.data(), size * sizeof(dtype)).wait();
+    q.memcpy(d_b, b.data(), size * sizeof(dtype)).wait();
+
+    {
+        driver.section("e = relu(a * x + b)");
+
+        BenchmarkOptions opt{
+            .total_mem_bytes = size * sizeof(dtype) * 4,
+            .total_flop = size * 3,
+        };
+        driver.run_ref("vector_relu_axpb_ref", [&] { vector_relu_axpb_ref(a, x, b, e); }, opt);
+
+        using func_t = std::function<void(sycl::queue &, dtype *, dtype *, dtype *, dtype *, dtype *, size_t)>;
+        std::vector<std::tuple<std::string, func_t> > funcs{
+            {"vector_relu_axpb_unfused", vector_relu_axpb_unfused<dtype, wg_size, sg_size, wi_size>},
+            {"vector_relu_axpb_fused_with_vec", vector_relu_axpb_fused_with_vec<dtype, wg_size, sg_size, wi_size>},
+            {
+                "vector_relu_axpb_fused_subgroup_continue",
+                vector_relu_axpb_fused_subgroup_continue<dtype, wg_size, sg_size, wi_size>
+            },
+        };
+
+        driver.run_all(funcs, opt,
+                       [&](func_t &func) { func(q, d_a, d_x, d_b, d_d, d_e, size); },
+                       [&] { q.fill(d_e, dtype{0}, size).wait(); },
+                       [&] { sycl_acc_check(q, e, d_e); });
+    }
+
+    {
+        driver.section("sum(relu(a * x + b))");
+
+        using Op = Sum<dtype>;
+        BenchmarkOptions opt{
+            .total_mem_bytes = size * sizeof(dtype) * 3,
+            .total_flop = size * 4,
+        };
+        double expected = 0;
+        driver.run_ref("vector_relu_axpb_sum_ref", [&] {
+            expected = bench::host_parallel_reduce(size, 0.0, [&](size_t begin, size_t end) {
+                return bench::host_simd_sum<double>(begin, end, [&](size_t i) {
+                    return std::max(a[i] * x[i] + b[i], dtype(0));
+                });
+            });
+        }, opt);
+
+        dtype *d_out = pool.malloc_device<dtype>(1, q);
+        size_t cu = q.get_device().get_info<sycl::info::device::max_compute_units>();
+        auto workspace = reduce_workspace_alloc<dtype>(q, cu * 4);
+
+        using func_t = std::function<void(sycl::queue &)>;
+        std::vector<std::tuple<std::string, func_t> > funcs{
+            {
+                "vector_relu_axpb_sum_unfused",
+                [&](sycl::queue &q) {
+                    vector_relu_axpb_unfused<dtype, wg_size, sg_size, wi_size>(q, d_a, d_x, d_b, d_d, d_e, size);
+                    reduce_group_last_group<Op, wg_size, sg_size, wi_size>(
+                        q, workspace, d_out, size, Identity<dtype>{}, d_e);
+                }
+            },
+            {
+                "vector_relu_axpb_sum_fused_last_group",
+                [&](sycl::queue &q) {
+                    reduce_expr<Op, wg_size, sg_size, wi_size>(
+                        q, workspace, d_out, size, relu(expr(d_a) * expr(d_x) + expr(d_b)));
+                }
+            },
+            {
+                "vector_relu_axpb_sum_fused_vec",
+                [&](sycl::queue &q) {
+                    reduce_expr_vec<Op, wg_size, sg_size, wi_size>(
+                        q, d_out, size, relu(expr(d_a) * expr(d_x) + expr(d_b)));
+                }
+            },
+        };
+
+        driver.run_all(funcs, opt,
+                       [&](func_t &func) { func(q); },
+                       [&] { q.memset(d_out, 0, sizeof(dtype)).wait(); },
+                       [&] {
+                           dtype result;
+                           q.memcpy(&result, d_out, sizeof(dtype)).wait();
+                           if (!same_sum(result, expected)) {
+                               throw std::runtime_error("result mismatch");
+                           }
+                       });
+
+        reduce_workspace_free(q, workspace);
+        pool.free(d_out, q);
+    }
+
+    pool.free(d_a, q);
+    pool.free(d_x, q);
+    pool.free(d_b, q);
+    pool.free(d_d, q);
+    pool.free(d_e, q);
+}
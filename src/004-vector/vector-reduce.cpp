@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/host-parallel.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/reduction.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Reductions other than the plain float sum, all built from the engine in reduction.hpp:
+// a double-accumulated sum of floats, min, max, argmax and the L2 norm.
+
+template<typename T>
+bool same_result(T a, T b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::abs(a - b) <= 1e-3 * std::max<T>(std::abs(b), 1);
+    } else {
+        return a == b;
+    }
+}
+
+template<typename T>
+bool same_result(ValueIndex<T> a, ValueIndex<T> b) {
+    return a.value == b.value && a.index == b.index;
+}
+
+template<typename Op, typename Transform, typename T>
+void test_reduce(bench::Driver &driver, const std::string &name, T *d_vec, size_t size,
+                 typename Op::acc_type expected) {
+    using namespace cbu;
+    using Acc = typename Op::acc_type;
+    constexpr size_t wg_size = 256;
+    constexpr size_t sg_size = 32;
+    constexpr size_t wi_size = 4;
+
+    driver.section(name);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    Acc *d_out = pool.malloc_device<Acc>(1, q);
+
+    size_t cu = q.get_device().get_info<sycl::info::device::max_compute_units>();
+    auto workspace = reduce_workspace_alloc<Acc>(q, cu * 4);
+
+    // Same signature as the engine strategies, so they are listed without wrappers.
+    using func_t = std::function<void(sycl::queue &, Acc *, size_t, Transform, T *)>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {
+            "reduce_sycl_reduction",
+            reduce_sycl_reduction<Op, Transform, T>
+        },
+        {
+            "reduce_group_recursion",
+            reduce_group_recursion<Op, wg_size, sg_size, Transform, T>
+        },
+        {
+            "reduce_group_last_group",
+            [&](sycl::queue &q, Acc *out, size_t size, Transform f, T *vec) {
+                reduce_group_last_group<Op, wg_size, sg_size, wi_size>(q, workspace, out, size, f, vec);
+            }
+        },
+    };
+    if constexpr (has_atomic_combine<Op>) {
+        std::vector<std::tuple<std::string, func_t> > atomic_funcs{
+            {
+                "reduce_atomic",
+                reduce_atomic<Op, Transform, T>
+            },
+            {
+                "reduce_group_atomic_collect",
+                reduce_group_atomic_collect<Op, wg_size, sg_size, Transform, T>
+            },
+            {
+                "reduce_group_atomic_collect_vec",
+                reduce_group_atomic_collect_vec<Op, wg_size, sg_size, wi_size, Transform, T>
+            },
+            {
+                "reduce_group_atomic_collect_sg",
+                reduce_group_atomic_collect_sg<Op, wg_size, sg_size, wi_size, Transform, T>
+            },
+        };
+        funcs.insert(funcs.end(), atomic_funcs.begin(), atomic_funcs.end());
+    }
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = size * sizeof(T),
+    };
+
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q, d_out, size, Transform{}, d_vec); },
+                   [&] { q.memset(d_out, 0, sizeof(Acc)).wait(); },
+                   [&] {
+                       Acc result;
+                       q.memcpy(&result, d_out, sizeof(Acc)).wait();
+                       if (!same_result(result, expected)) {
+                           throw std::runtime_error("result mismatch");
+                       }
+                   });
+
+    reduce_workspace_free(q, workspace);
+    pool.free(d_out, q);
+}
+
+
+int main(int argc, char *argv[]) {
+    using namespace cbu;
+    using dtype = float;
+
+    bench::Driver driver{argc, argv};
+    size_t size = driver.arg("size", 64 * 1024 * 1024); // 64M elements
+
+    std::vector<dtype> vec(size);
+    random_fill(vec);
+
+    double sum = bench::host_parallel_reduce(size, 0.0, [&](size_t begin, size_t end) {
+        return bench::host_simd_sum<double>(begin, end, [&](size_t i) { return double(vec[i]); });
+    });
+    double sum_sq = bench::host_parallel_reduce(size, 0.0, [&](size_t begin, size_t end) {
+        return bench::host_simd_sum<double>(begin, end, [&](size_t i) { return double(vec[i]) * vec[i]; });
+    });
+    auto min_it = std::min_element(vec.begin(), vec.end());
+    auto max_it = std::max_element(vec.begin(), vec.end()); // first maximum, same as ArgMax
+    ValueIndex<dtype> arg_max{*max_it, static_cast<uint64_t>(max_it - vec.begin())};
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_vec = pool.malloc_device<dtype>(size, q);
+    q.memcpy(d_vec, vec.data(), size * sizeof(dtype)).wait();
+
+    // double kernels and atomics need fp64, which many GPUs lack
+    if (q.get_device().has(sycl::aspect::fp64)) {
+        test_reduce<Sum<double>, Identity<double> >(driver, "sum, double accumulator", d_vec, size, sum);
+    } else {
+        driver.log() << "sum, double accumulator: skipped, the device has no fp64\n";
+    }
+    test_reduce<Min<dtype>, Identity<dtype> >(driver, "min", d_vec, size, *min_it);
+    test_reduce<Max<dtype>, Identity<dtype> >(driver, "max", d_vec, size, *max_it);
+    test_reduce<ArgMax<dtype>, WithIndex<dtype> >(driver, "argmax", d_vec, size, arg_max);
+    test_reduce<Norm2<dtype>, Square<dtype> >(driver, "l2 norm", d_vec, size, static_cast<dtype>(std::sqrt(sum_sq)));
+
+    pool.free(d_vec, q);
+}
@@ -0,0 +1,79 @@
+#include <random>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/vector-copy.hpp"
+#include "004-vector/vector-scan.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Exclusive and inclusive prefix sums of 32-bit unsigned integers (exact in any order) against a plain copy of
+// the same bytes, the baseline. GB/s counts one read and one write of the data, so multi-pass scans show
+// their effective rate and a single-pass scan can approach copy bandwidth.
+
+constexpr size_t wg_size = 256;
+constexpr size_t sg_size = 32;
+constexpr size_t wi_size = 8;
+
+template<scan_type type, typename T>
+void test_vector_scan(bench::Driver &driver, const std::vector<T> &vec, T *d_in, T *d_out, ScanWorkspace<T> &ws) {
+    using namespace cbu;
+    driver.section(type == scan_type::exclusive ? "exclusive" : "inclusive");
+
+    size_t size = vec.size();
+    std::vector<T> out(size);
+    BenchmarkOptions opt{
+        .total_mem_bytes = size * sizeof(T) * 2,
+        .total_flop = size,
+    };
+    driver.run_ref("vector_scan_ref", [&] { vector_scan_ref<T, type>(vec, out); }, opt);
+
+    sycl::queue &q = driver.queue();
+    driver.run("vector_copy_with_vec", [&] {
+        vector_copy_with_vec<T, wg_size, sg_size, 4>(q, d_in, d_out, size);
+        q.wait();
+    }, opt);
+    driver.baseline("vector_copy_with_vec");
+
+    using func_t = std::function<void(sycl::queue &, ScanWorkspace<T> &, T *, T *, size_t)>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {"vector_scan_three_pass", vector_scan_three_pass<T, type, wg_size, sg_size>},
+        {"vector_scan_reduce_scan", vector_scan_reduce_scan<T, type, wg_size, sg_size, wi_size>},
+        {"vector_scan_look_back", vector_scan_look_back<T, type, wg_size, sg_size, wi_size>},
+    };
+
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q, ws, d_in, d_out, size); },
+                   [&] { q.fill(d_out, T{0}, size).wait(); },
+                   [&] { sycl_acc_check(q, out, d_out); });
+}
+
+
+int main(int argc, char *argv[]) {
+    using dtype = uint32_t;
+
+    bench::Driver driver{argc, argv};
+    size_t size = driver.arg("size", 100 * 1024 * 1024); // 100M elements
+
+    // small values like the counts scanned for compaction or CSR row pointers
+    std::vector<dtype> vec(size);
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<dtype> count(0, 15);
+    for (auto &x: vec) {
+        x = count(rng);
+    }
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_in = pool.malloc_device<dtype>(size, q);
+    auto *d_out = pool.malloc_device<dtype>(size, q);
+    q.memcpy(d_in, vec.data(), size * sizeof(dtype)).wait();
+    auto ws = scan_workspace_alloc<dtype>(q, ceil_div(size, wg_size)); // three_pass has the smallest tiles
+
+    test_vector_scan<scan_type::exclusive>(driver, vec, d_in, d_out, ws);
+    test_vector_scan<scan_type::inclusive>(driver, vec, d_in, d_out, ws);
+
+    scan_workspace_free(q, ws);
+    pool.free(d_in, q);
+    pool.free(d_out, q);
+}
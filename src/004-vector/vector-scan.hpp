@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+
+// Device-wide prefix sums, out[i] = in[0] + ... + in[i - 1] (exclusive) or + in[i] (inclusive).
+//
+// The input is cut into tiles, one per work-group, and the strategies differ in how tiles learn the sum of
+// everything before them:
+//   three_pass    scan each tile in SLM (Hillis-Steele), scan the tile sums in a single_task, add them back;
+//                 reads and writes the data twice
+//   reduce_scan   reduce every tile, joint_exclusive_scan the tile sums in one work-group, then scan every
+//                 tile again with exclusive_scan_over_group and its carry; reads the data twice
+//   look_back     single pass, decoupled look-back (Merrill & Garland): a tile publishes its sum, then
+//                 walks back over the status of its predecessors until one has its inclusive prefix.
+//                 Tiles take their id from an atomic counter in the order they start, so every tile
+//                 waited on is already running.
+// Every work-item of the group strategies owns WI_SIZE consecutive elements of the tile.
+
+enum class scan_type { exclusive, inclusive };
+
+// Scratch allocated once for the largest size and reused by every call.
+template<typename T>
+struct ScanWorkspace {
+    T *partials; // one per tile, the tile sums
+    T *prefixes; // one per tile, their exclusive scan
+    uint64_t *status; // look_back: per tile epoch, flag and value
+    uint32_t *counter; // look_back: next dynamic tile id, back to 0 when a launch ends
+    size_t capacity; // max tiles per launch
+    uint32_t epoch; // look_back launch number, tells this launch's status words from stale ones
+};
+
+template<typename T>
+ScanWorkspace<T> scan_workspace_alloc(sycl::queue &q, size_t capacity) {
+    auto &pool = bench::usm_pool();
+    ScanWorkspace<T> ws{
+        pool.malloc_device<T>(capacity, q),
+        pool.malloc_device<T>(capacity, q),
+        pool.malloc_device<uint64_t>(capacity, q),
+        pool.malloc_device<uint32_t>(1, q),
+        capacity,
+        0
+    };
+    q.memset(ws.status, 0, capacity * sizeof(uint64_t)).wait();
+    q.memset(ws.counter, 0, sizeof(uint32_t)).wait();
+    return ws;
+}
+
+template<typename T>
+void scan_workspace_free(sycl::queue &q, ScanWorkspace<T> &ws) {
+    auto &pool = bench::usm_pool();
+    pool.free(ws.partials, q);
+    pool.free(ws.prefixes, q);
+    pool.free(ws.status, q);
+    pool.free(ws.counter, q);
+}
+
+template<typename T, scan_type type>
+void vector_scan_ref(const std::vector<T> &in, std::vector<T> &out) {
+    // sums of host blocks, their scan, then every block scanned from its offset
+    size_t size = in.size(), block = bench::host_block_size(size, 1 << 16);
+    std::vector<T> offset((size + block - 1) / block, T{0});
+    bench::host_pool().run(offset.size(), [&](size_t b) {
+        for (size_t i = b * block; i < std::min((b + 1) * block, size); i++) {
+            offset[b] += in[i];
+        }
+    });
+    T running{0};
+    for (T &o: offset) {
+        T sum = o;
+        o = running;
+        running += sum;
+    }
+    bench::host_pool().run(offset.size(), [&](size_t b) {
+        T acc = offset[b];
+        for (size_t i = b * block; i < std::min((b + 1) * block, size); i++) {
+            if constexpr (type == scan_type::inclusive) {
+                acc += in[i];
+                out[i] = acc;
+            } else {
+                out[i] = acc;
+                acc += in[i];
+            }
+        }
+    });
+}
+
+// Writes the WI_SIZE elements of a work-item scanned from its prefix.
+template<scan_type type, typename T, size_t WI_SIZE>
+void scan_store(T *out, size_t base, size_t size, const T (&x)[WI_SIZE], T prefix) {
+    for (size_t j = 0; j < WI_SIZE && base + j < size; j++) {
+        if constexpr (type == scan_type::inclusive) {
+            prefix += x[j];
+            out[base + j] = prefix;
+        } else {
+            out[base + j] = prefix;
+            prefix += x[j];
+        }
+    }
+}
+
+template<typename T, size_t WI_SIZE>
+T scan_load(const T *in, size_t base, size_t size, T (&x)[WI_SIZE]) {
+    T sum{0};
+    for (size_t j = 0; j < WI_SIZE; j++) {
+        x[j] = base + j < size ? in[base + j] : T{0};
+        sum += x[j];
+    }
+    return sum;
+}
+
+template<typename T, scan_type type, size_t WG_SIZE, size_t SG_SIZE>
+void vector_scan_three_pass(sycl::queue &q, ScanWorkspace<T> &ws, T *in, T *out, size_t size) {
+    size_t tiles = ceil_div(size, WG_SIZE);
+    if (tiles > ws.capacity) throw std::length_error("scan workspace too small");
+    T *partials = ws.partials;
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<T, 1> slm{WG_SIZE, h};
+        h.parallel_for(
+            sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+            [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t i = item.get_global_id(0), l_i = item.get_local_id(0);
+                T x = i < size ? in[i] : T{0};
+                slm[l_i] = x;
+                for (size_t offset = 1; offset < WG_SIZE; offset *= 2) {
+                    item.barrier(sycl::access::fence_space::local_space);
+                    T t = l_i >= offset ? slm[l_i - offset] : T{0};
+                    item.barrier(sycl::access::fence_space::local_space);
+                    slm[l_i] += t;
+                }
+                if (i < size) {
+                    out[i] = type == scan_type::inclusive ? slm[l_i] : slm[l_i] - x;
+                }
+                if (l_i == WG_SIZE - 1) {
+                    partials[item.get_group(0)] = slm[l_i];
+                }
+            });
+    }));
+
+    bench::track(q.single_task([=] {
+        T running{0};
+        for (size_t g = 0; g < tiles; g++) {
+            T sum = partials[g];
+            partials[g] = running;
+            running += sum;
+        }
+    }));
+
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t i = item.get_global_id(0);
+            if (i < size) {
+                out[i] += partials[item.get_group(0)];
+            }
+        }));
+}
+
+template<typename T, scan_type type, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_scan_reduce_scan(sycl::queue &q, ScanWorkspace<T> &ws, T *in, T *out, size_t size) {
+    constexpr size_t TILE = WG_SIZE * WI_SIZE;
+    size_t tiles = ceil_div(size, TILE);
+    if (tiles > ws.capacity) throw std::length_error("scan workspace too small");
+    T *partials = ws.partials, *prefixes = ws.prefixes;
+
+    // tile sums, neighbouring work-items read neighbouring elements
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t base = item.get_group(0) * TILE + item.get_local_id(0);
+            T sum{0};
+            for (size_t j = 0; j < WI_SIZE; j++) {
+                if (base + j * WG_SIZE < size) sum += in[base + j * WG_SIZE];
+            }
+            T tile_sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<T>());
+            if (item.get_group().leader()) {
+                partials[item.get_group(0)] = tile_sum;
+            }
+        }));
+
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{WG_SIZE, WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            sycl::joint_exclusive_scan(item.get_group(), partials, partials + tiles, prefixes, sycl::plus<T>());
+        }));
+
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t base = item.get_group(0) * TILE + item.get_local_id(0) * WI_SIZE;
+            T x[WI_SIZE];
+            T sum = scan_load(in, base, size, x);
+            T prefix = sycl::exclusive_scan_over_group(item.get_group(), sum, sycl::plus<T>());
+            scan_store<type>(out, base, size, x, prefixes[item.get_group(0)] + prefix);
+        }));
+}
+
+// Look-back status word: epoch (30 bits) | flag (2 bits) | value bits (32 bits).
+namespace scan_detail {
+    constexpr uint64_t flag_aggregate = 1, flag_prefix = 2;
+    constexpr uint32_t epoch_mask = (1u << 30) - 1;
+
+    template<typename T>
+    uint64_t pack_status(uint32_t epoch, uint64_t flag, T value) {
+        return uint64_t(epoch) << 34 | flag << 32 | std::bit_cast<uint32_t>(value);
+    }
+}
+
+template<typename T, scan_type type, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_scan_look_back(sycl::queue &q, ScanWorkspace<T> &ws, T *in, T *out, size_t size) {
+    using namespace scan_detail;
+    static_assert(sizeof(T) == 4, "look-back packs a 32-bit value into the status word");
+    constexpr size_t TILE = WG_SIZE * WI_SIZE;
+    size_t tiles = ceil_div(size, TILE);
+    if (tiles > ws.capacity) throw std::length_error("scan workspace too small");
+    ws.epoch = ws.epoch % epoch_mask + 1; // 0 is the zeroed status of a fresh workspace
+    uint32_t epoch = ws.epoch;
+    uint64_t *status = ws.status;
+    uint32_t *counter = ws.counter;
+
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            using status_ref = sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                sycl::access::address_space::global_space>;
+            auto group = item.get_group();
+            auto sg = item.get_sub_group();
+
+            uint32_t tile = 0;
+            if (group.leader()) {
+                auto next = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                    sycl::access::address_space::global_space>(counter[0]);
+                tile = next.fetch_add(1);
+                if (tile == tiles - 1) next.store(0); // every id of this launch is taken
+            }
+            tile = sycl::group_broadcast(group, tile);
+
+            size_t base = tile * TILE + item.get_local_id(0) * WI_SIZE;
+            T x[WI_SIZE];
+            T sum = scan_load(in, base, size, x);
+            T prefix = sycl::exclusive_scan_over_group(group, sum, sycl::plus<T>());
+            T aggregate = sycl::group_broadcast(group, prefix + sum, WG_SIZE - 1);
+
+            // The first sub-group looks back SG_SIZE predecessors at a time, lane l at tile - 1 - l.
+            T exclusive{0};
+            if (sg.get_group_linear_id() == 0) {
+                uint32_t lane = sg.get_local_linear_id();
+                if (lane == 0) {
+                    uint64_t flag = tile == 0 ? flag_prefix : flag_aggregate;
+                    status_ref(status[tile]).store(pack_status(epoch, flag, aggregate));
+                }
+                for (int64_t end = tile; end > 0; end -= SG_SIZE) {
+                    int64_t p = end - 1 - lane;
+                    uint64_t flag = flag_prefix;
+                    T value{0};
+                    if (p >= 0) {
+                        uint64_t word;
+                        do {
+                            word = status_ref(status[p]).load();
+                        } while ((word >> 34) != epoch);
+                        flag = word >> 32 & 3;
+                        value = std::bit_cast<T>(static_cast<uint32_t>(word));
+                    }
+                    uint32_t first = sycl::reduce_over_group(sg, flag == flag_prefix ? lane : uint32_t(SG_SIZE),
+                                                             sycl::minimum<uint32_t>());
+                    exclusive += sycl::reduce_over_group(sg, lane <= first ? value : T{0}, sycl::plus<T>());
+                    if (first < SG_SIZE) break;
+                }
+                if (lane == 0 && tile > 0) {
+                    status_ref(status[tile]).store(pack_status(epoch, flag_prefix, exclusive + aggregate));
+                }
+            }
+            exclusive = sycl::group_broadcast(group, exclusive, 0);
+
+            scan_store<type>(out, base, size, x, exclusive + prefix);
+        }));
+}
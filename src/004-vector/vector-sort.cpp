@@ -0,0 +1,213 @@
+#if __has_include(<oneapi/dpl/algorithm>)
+// before the other headers, as oneDPL asks
+#include <oneapi/dpl/execution>
+#include <oneapi/dpl/algorithm>
+#endif
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/vector-sort.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Radix sort of 32-bit keys and key/value pairs, and top-k of float scores, against std::sort on the host
+// (the speedup baseline) and oneDPL when its headers are found. Sorting is in place, so every sort variant
+// first copies the unsorted input back, the reference included. GFLOP/s is G keys/s; GB/s counts one read
+// and one write of the keys and values.
+
+constexpr size_t wg_size = 256;
+constexpr size_t sg_size = 32;
+constexpr size_t wi_size = 8;
+constexpr size_t tile_size = wg_size * wi_size;
+
+template<typename K, typename V = uint32_t>
+void test_radix_sort(bench::Driver &driver, const std::string &name, const std::vector<K> &keys, bool pairs) {
+    using namespace cbu;
+    driver.section(name);
+
+    size_t size = keys.size();
+    std::vector<V> values(size);
+    for (size_t i = 0; i < size; i++) values[i] = static_cast<V>(i);
+
+    // pairs of (key, index) sort into the stable order of the keys
+    std::vector<K> sorted_keys(size);
+    std::vector<V> sorted_values(size);
+    std::vector<std::pair<K, V> > ref(size);
+    BenchmarkOptions opt{
+        .total_mem_bytes = size * (sizeof(K) + (pairs ? sizeof(V) : 0)) * 2,
+        .total_flop = size,
+    };
+    driver.run_ref("std_sort", [&] {
+        if (pairs) {
+            for (size_t i = 0; i < size; i++) ref[i] = {keys[i], values[i]};
+            std::sort(ref.begin(), ref.end());
+        } else {
+            sorted_keys = keys;
+            std::sort(sorted_keys.begin(), sorted_keys.end());
+        }
+    }, opt);
+    if (pairs) {
+        for (size_t i = 0; i < size; i++) std::tie(sorted_keys[i], sorted_values[i]) = ref[i];
+    }
+    driver.baseline("std_sort");
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_in = pool.malloc_device<K>(size, q);
+    auto *d_keys = pool.malloc_device<K>(size, q);
+    auto *d_values_in = pool.malloc_device<V>(size, q);
+    auto *d_values = pool.malloc_device<V>(size, q);
+    q.memcpy(d_in, keys.data(), size * sizeof(K)).wait();
+    q.memcpy(d_values_in, values.data(), size * sizeof(V)).wait();
+    auto ws = sort_workspace_alloc<K, V>(q, size, tile_size);
+
+    auto copy_input = [&] {
+        bench::track(q.memcpy(d_keys, d_in, size * sizeof(K)));
+        if (pairs) bench::track(q.memcpy(d_values, d_values_in, size * sizeof(V)));
+    };
+    using func_t = std::function<void()>;
+    std::vector<std::tuple<std::string, func_t> > funcs;
+    if (pairs) {
+        funcs.emplace_back("radix_sort_pairs", [&] {
+            copy_input();
+            radix_sort_pairs<K, V, false, wg_size, sg_size, wi_size>(q, ws, d_keys, d_values, size);
+        });
+    } else {
+        funcs.emplace_back("radix_sort", [&] {
+            copy_input();
+            radix_sort<K, V, false, wg_size, sg_size, wi_size>(q, ws, d_keys, size);
+        });
+    }
+#if __has_include(<oneapi/dpl/algorithm>)
+    // oneDPL's kernels are not tracked, these variants have wall-clock times only
+    funcs.emplace_back(pairs ? "dpl_sort_by_key" : "dpl_sort", [&] {
+        q.memcpy(d_keys, d_in, size * sizeof(K));
+        if (pairs) q.memcpy(d_values, d_values_in, size * sizeof(V));
+        auto policy = oneapi::dpl::execution::make_device_policy(q);
+        if (pairs) {
+            oneapi::dpl::sort_by_key(policy, d_keys, d_keys + size, d_values);
+        } else {
+            oneapi::dpl::sort(policy, d_keys, d_keys + size);
+        }
+    });
+#endif
+
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(); },
+                   [&] { q.fill(d_keys, K{0}, size).wait(); },
+                   [&] {
+                       sycl_acc_check(q, sorted_keys, d_keys);
+                       if (pairs) sycl_acc_check(q, sorted_values, d_values);
+                   });
+
+    sort_workspace_free(q, ws);
+    pool.free(d_in, q);
+    pool.free(d_keys, q);
+    pool.free(d_values_in, q);
+    pool.free(d_values, q);
+}
+
+template<typename K>
+void test_top_k(bench::Driver &driver, const std::vector<K> &scores, size_t k) {
+    using namespace cbu;
+    driver.section("top-" + std::to_string(k));
+
+    size_t size = scores.size();
+    std::vector<uint32_t> order(size);
+    BenchmarkOptions opt{
+        .total_mem_bytes = size * sizeof(K),
+        .total_flop = size,
+    };
+    driver.run_ref("std_partial_sort", [&] {
+        for (size_t i = 0; i < size; i++) order[i] = static_cast<uint32_t>(i);
+        std::partial_sort(order.begin(), order.begin() + k, order.end(), [&](uint32_t a, uint32_t b) {
+            return scores[a] > scores[b];
+        });
+    }, opt);
+    std::vector<K> expected(k);
+    for (size_t i = 0; i < k; i++) expected[i] = scores[order[i]];
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_scores = pool.malloc_device<K>(size, q);
+    auto *d_top_keys = pool.malloc_device<K>(k, q);
+    auto *d_top_indices = pool.malloc_device<uint32_t>(k, q);
+    q.memcpy(d_scores, scores.data(), size * sizeof(K)).wait();
+    auto ws = top_k_workspace_alloc<K>(q, size, tile_size);
+
+    // ties at the k-th score may pick other indices, so the scores are compared and the indices must point at them
+    auto reset = [&] { q.memset(d_top_indices, 0xff, k * sizeof(uint32_t)).wait(); };
+    auto check = [&] {
+        std::vector<K> top_keys(k);
+        std::vector<uint32_t> top_indices(k);
+        q.memcpy(top_keys.data(), d_top_keys, k * sizeof(K)).wait();
+        q.memcpy(top_indices.data(), d_top_indices, k * sizeof(uint32_t)).wait();
+        for (size_t i = 0; i < k; i++) {
+            if (top_keys[i] != expected[i] || top_indices[i] >= size || scores[top_indices[i]] != top_keys[i]) {
+                throw std::runtime_error("result mismatch");
+            }
+        }
+    };
+
+    reset();
+    driver.run("vector_top_k_sort", [&] {
+        vector_top_k_sort<K, wg_size, sg_size, wi_size>(q, ws, d_scores, size, k, d_top_keys, d_top_indices);
+        q.wait();
+    }, opt, check);
+    driver.baseline("vector_top_k_sort");
+
+    using func_t = std::function<void()>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {
+            "vector_top_k_select", [&] {
+                vector_top_k_select<K, wg_size, sg_size, wi_size>(
+                    q, ws, d_scores, size, k, d_top_keys, d_top_indices);
+            }
+        },
+    };
+#if __has_include(<oneapi/dpl/algorithm>)
+    funcs.emplace_back("dpl_sort_by_key", [&] {
+        q.memcpy(ws.keys, d_scores, size * sizeof(K));
+        auto policy = oneapi::dpl::execution::make_device_policy(q);
+        oneapi::dpl::copy(policy, oneapi::dpl::counting_iterator<uint32_t>(0),
+                          oneapi::dpl::counting_iterator<uint32_t>(size), ws.indices);
+        oneapi::dpl::sort_by_key(policy, ws.keys, ws.keys + size, ws.indices, std::greater<K>());
+        q.memcpy(d_top_keys, ws.keys, k * sizeof(K));
+        q.memcpy(d_top_indices, ws.indices, k * sizeof(uint32_t));
+    });
+#endif
+
+    driver.run_all(funcs, opt, [&](func_t &func) { func(); }, reset, check);
+
+    top_k_workspace_free(q, ws);
+    pool.free(d_scores, q);
+    pool.free(d_top_keys, q);
+    pool.free(d_top_indices, q);
+}
+
+
+int main(int argc, char *argv[]) {
+    bench::Driver driver{argc, argv};
+    size_t size = driver.arg("size", 10 * 1024 * 1024); // 10M keys
+    size_t k = driver.arg("k", 100);
+    if (k == 0 || k > size) throw std::invalid_argument("--k must be in [1, size]");
+
+    std::mt19937 rng{42};
+    std::vector<uint32_t> keys(size);
+    std::uniform_int_distribution<uint32_t> bits;
+    for (auto &x: keys) x = bits(rng);
+
+    std::vector<float> scores(size);
+    std::normal_distribution<float> score;
+    for (auto &x: scores) x = score(rng);
+
+    test_radix_sort<uint32_t>(driver, "uint32 keys", keys, false);
+    test_radix_sort<float>(driver, "float keys", scores, false);
+    test_radix_sort<uint32_t>(driver, "uint32 keys, uint32 values", keys, true);
+    test_top_k(driver, scores, k);
+}
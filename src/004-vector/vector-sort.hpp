@@ -0,0 +1,377 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <sycl/sycl.hpp>
+
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/vector-scan.hpp"
+
+// Device radix sort and top-k of 32-bit keys (unsigned, signed or float), optionally carrying a value each.
+//
+// radix_sort_pairs is an LSD sort over 8-bit digits, four passes, each of them
+//   histogram   every work-group counts the digits of its tile in SLM
+//   scan        the tile histograms, stored digit-major, are scanned with vector_scan_look_back into the
+//               first output position of every (digit, tile)
+//   scatter     every work-group ranks its tile WG_SIZE keys at a time and writes them to their positions
+// Ranking is stable, keys of one digit keep their order, so every pass keeps the order of the previous ones.
+// Within a sub-group the lanes holding the same digit are found with RADIX_BITS ballots (a "match"): the
+// lowest of them adds the count to the SLM histogram once, and each one's rank is the number of matching
+// lanes below it. The SLM atomics per digit drop from one per key to one per sub-group.
+//
+// vector_top_k_select finds the k largest keys without sorting them all: a radix select walks the digits from
+// the top, 4 histogram passes narrow the candidates down to the exact k-th key, one pass gathers the k
+// winners, and only those are sorted. vector_top_k_sort sorts everything and keeps the first k, for comparison.
+
+namespace sort_detail {
+    constexpr uint32_t radix_bits = 8, radix = 1u << radix_bits;
+
+    // Bits of a key whose unsigned order is the order of the keys, reversed for a descending sort.
+    template<typename K, bool DESCENDING>
+    uint32_t ordered_bits(K key) {
+        uint32_t bits = std::bit_cast<uint32_t>(key);
+        if constexpr (std::is_floating_point_v<K>) {
+            bits ^= bits >> 31 ? 0xffffffffu : 0x80000000u; // negatives reversed, below the positives
+        } else if constexpr (std::is_signed_v<K>) {
+            bits ^= 0x80000000u;
+        }
+        return DESCENDING ? ~bits : bits;
+    }
+
+    // Mask of the valid lanes of the sub-group whose digit equals this lane's.
+    template<typename SubGroup>
+    uint32_t match_digit(SubGroup sg, uint32_t digit, bool valid) {
+        uint32_t peers, ones;
+        sycl::ext::oneapi::group_ballot(sg, valid).extract_bits(peers);
+        for (uint32_t b = 0; b < radix_bits; b++) {
+            bool bit = digit >> b & 1;
+            sycl::ext::oneapi::group_ballot(sg, bit).extract_bits(ones);
+            peers &= bit ? ones : ~ones;
+        }
+        return peers;
+    }
+
+    // hist[digit] += 1 for every valid lane, one SLM atomic per distinct digit of the sub-group.
+    template<typename SubGroup>
+    void histogram_add(SubGroup sg, const sycl::local_accessor<uint32_t, 1> &hist, uint32_t digit, bool valid) {
+        uint32_t peers = match_digit(sg, digit, valid);
+        if (valid && std::countr_zero(peers) == sg.get_local_linear_id()) {
+            sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::work_group,
+                sycl::access::address_space::local_space>(hist[digit]) += std::popcount(peers);
+        }
+    }
+}
+
+// Scratch allocated once for the largest size and reused by every call.
+template<typename K, typename V = uint32_t>
+struct SortWorkspace {
+    K *keys; // the other half of the ping-pong between passes
+    V *values;
+    uint32_t *histograms; // radix x tiles, digit-major, scanned in place into scatter offsets
+    ScanWorkspace<uint32_t> scan;
+    size_t tiles; // max tiles per sort
+};
+
+// tile is WG_SIZE * WI_SIZE of the sorts that will use the workspace.
+template<typename K, typename V = uint32_t>
+SortWorkspace<K, V> sort_workspace_alloc(sycl::queue &q, size_t capacity, size_t tile) {
+    auto &pool = bench::usm_pool();
+    size_t tiles = ceil_div(capacity, tile);
+    return {
+        pool.malloc_device<K>(capacity, q),
+        pool.malloc_device<V>(capacity, q),
+        pool.malloc_device<uint32_t>(sort_detail::radix * tiles, q),
+        scan_workspace_alloc<uint32_t>(q, ceil_div(sort_detail::radix * tiles, tile)),
+        tiles
+    };
+}
+
+template<typename K, typename V>
+void sort_workspace_free(sycl::queue &q, SortWorkspace<K, V> &ws) {
+    auto &pool = bench::usm_pool();
+    pool.free(ws.keys, q);
+    pool.free(ws.values, q);
+    pool.free(ws.histograms, q);
+    scan_workspace_free(q, ws.scan);
+}
+
+// Sorts keys and moves values (nullptr for none) along with them, in place.
+template<typename K, typename V, bool DESCENDING, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void radix_sort_pairs(sycl::queue &q, SortWorkspace<K, V> &ws, K *keys, V *values, size_t size) {
+    using namespace sort_detail;
+    static_assert(sizeof(K) == 4, "radix_sort sorts 32-bit keys");
+    static_assert(WG_SIZE >= radix, "one work-item per digit scans the sub-group counts");
+    static_assert(SG_SIZE <= 32, "ballots are read as 32-bit masks");
+    static_assert(32 / radix_bits % 2 == 0, "an even number of passes ends in keys and values");
+    constexpr size_t TILE = WG_SIZE * WI_SIZE, SG_NUM = WG_SIZE / SG_SIZE;
+    size_t tiles = ceil_div(size, TILE);
+    if (tiles > ws.tiles) throw std::length_error("sort workspace too small");
+    if (size == 0) return;
+
+    K *keys_in = keys, *keys_out = ws.keys;
+    V *values_in = values, *values_out = values ? ws.values : nullptr;
+    uint32_t *histograms = ws.histograms;
+
+    for (uint32_t shift = 0; shift < 32; shift += radix_bits) {
+        // neighbouring work-items read neighbouring keys, so the sub-groups of the scatter see the same ones
+        bench::track(q.submit([&](sycl::handler &h) {
+            sycl::local_accessor<uint32_t, 1> hist{radix, h};
+            h.parallel_for(
+                sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+                [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                    size_t l_i = item.get_local_id(0), tile = item.get_group(0);
+                    if (l_i < radix) hist[l_i] = 0;
+                    item.barrier(sycl::access::fence_space::local_space);
+
+                    for (size_t j = 0; j < WI_SIZE; j++) {
+                        size_t i = tile * TILE + j * WG_SIZE + l_i;
+                        bool valid = i < size;
+                        uint32_t bits = valid ? ordered_bits<K, DESCENDING>(keys_in[i]) : 0;
+                        histogram_add(item.get_sub_group(), hist, bits >> shift & (radix - 1), valid);
+                    }
+                    item.barrier(sycl::access::fence_space::local_space);
+                    if (l_i < radix) histograms[l_i * tiles + tile] = hist[l_i];
+                });
+        }));
+
+        vector_scan_look_back<uint32_t, scan_type::exclusive, WG_SIZE, SG_SIZE, WI_SIZE>(
+            q, ws.scan, histograms, histograms, radix * tiles);
+
+        bench::track(q.submit([&](sycl::handler &h) {
+            sycl::local_accessor<uint32_t, 1> offsets{radix, h}; // next position of every digit
+            sycl::local_accessor<uint32_t, 1> sg_counts{SG_NUM * radix, h};
+            h.parallel_for(
+                sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+                [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                    auto sg = item.get_sub_group();
+                    size_t l_i = item.get_local_id(0), tile = item.get_group(0);
+                    size_t sg_id = sg.get_group_linear_id();
+                    uint32_t lane = sg.get_local_linear_id();
+                    if (l_i < radix) offsets[l_i] = histograms[l_i * tiles + tile];
+
+                    // WG_SIZE keys per round, in order: sub-groups by id, lanes by rank
+                    for (size_t j = 0; j < WI_SIZE; j++) {
+                        for (size_t s = l_i; s < SG_NUM * radix; s += WG_SIZE) {
+                            sg_counts[s] = 0;
+                        }
+                        item.barrier(sycl::access::fence_space::local_space);
+
+                        size_t i = tile * TILE + j * WG_SIZE + l_i;
+                        bool valid = i < size;
+                        K key = valid ? keys_in[i] : K{};
+                        uint32_t digit = ordered_bits<K, DESCENDING>(key) >> shift & (radix - 1);
+                        uint32_t peers = match_digit(sg, digit, valid);
+                        uint32_t rank = std::popcount(peers & ((1u << lane) - 1));
+                        if (valid && std::countr_zero(peers) == lane) {
+                            sg_counts[sg_id * radix + digit] = std::popcount(peers);
+                        }
+                        item.barrier(sycl::access::fence_space::local_space);
+
+                        // sub-group counts of every digit into their first positions
+                        if (l_i < radix) {
+                            uint32_t running = offsets[l_i];
+                            for (size_t s = 0; s < SG_NUM; s++) {
+                                uint32_t count = sg_counts[s * radix + l_i];
+                                sg_counts[s * radix + l_i] = running;
+                                running += count;
+                            }
+                            offsets[l_i] = running;
+                        }
+                        item.barrier(sycl::access::fence_space::local_space);
+
+                        if (valid) {
+                            uint32_t pos = sg_counts[sg_id * radix + digit] + rank;
+                            keys_out[pos] = key;
+                            if (values_in) values_out[pos] = values_in[i];
+                        }
+                        item.barrier(sycl::access::fence_space::local_space);
+                    }
+                });
+        }));
+
+        std::swap(keys_in, keys_out);
+        std::swap(values_in, values_out);
+    }
+}
+
+template<typename K, typename V, bool DESCENDING, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void radix_sort(sycl::queue &q, SortWorkspace<K, V> &ws, K *keys, size_t size) {
+    radix_sort_pairs<K, V, DESCENDING, WG_SIZE, SG_SIZE, WI_SIZE>(q, ws, keys, static_cast<V *>(nullptr), size);
+}
+
+// Radix select state, in device memory so the passes run without a round trip to the host.
+struct TopKState {
+    uint32_t prefix; // ordered bits of the k-th largest key found so far, the digits above the current one
+    uint32_t remaining; // how many keys matching the prefix are still to be taken
+    uint32_t above; // gather: next slot of the keys ordered before the k-th one
+    uint32_t equal; // gather: keys equal to the k-th one taken so far
+};
+
+template<typename K>
+struct TopKWorkspace {
+    uint32_t *histogram; // radix bins of the current digit
+    TopKState *state;
+    K *keys; // top_k_sort: a copy of all the keys
+    uint32_t *indices; // top_k_sort: their indices
+    SortWorkspace<K, uint32_t> sort; // top_k_sort sorts all the keys, top_k_select only k of them
+};
+
+template<typename K>
+TopKWorkspace<K> top_k_workspace_alloc(sycl::queue &q, size_t capacity, size_t tile) {
+    auto &pool = bench::usm_pool();
+    return {
+        pool.malloc_device<uint32_t>(sort_detail::radix, q),
+        pool.malloc_device<TopKState>(1, q),
+        pool.malloc_device<K>(capacity, q),
+        pool.malloc_device<uint32_t>(capacity, q),
+        sort_workspace_alloc<K, uint32_t>(q, capacity, tile)
+    };
+}
+
+template<typename K>
+void top_k_workspace_free(sycl::queue &q, TopKWorkspace<K> &ws) {
+    auto &pool = bench::usm_pool();
+    pool.free(ws.histogram, q);
+    pool.free(ws.state, q);
+    pool.free(ws.keys, q);
+    pool.free(ws.indices, q);
+    sort_workspace_free(q, ws.sort);
+}
+
+inline void top_k_check(size_t size, size_t k) {
+    if (k == 0 || k > size) throw std::invalid_argument("top-k needs 0 < k <= size");
+}
+
+// The k largest keys in descending order and their indices, by sorting all of them.
+template<typename K, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_top_k_sort(sycl::queue &q, TopKWorkspace<K> &ws, K *keys, size_t size, size_t k,
+                       K *top_keys, uint32_t *top_indices) {
+    top_k_check(size, k);
+    K *all_keys = ws.keys;
+    uint32_t *indices = ws.indices;
+    bench::track(q.parallel_for(sycl::range<1>{size}, [=](sycl::id<1> i) {
+        all_keys[i] = keys[i];
+        indices[i] = static_cast<uint32_t>(i);
+    }));
+    radix_sort_pairs<K, uint32_t, true, WG_SIZE, SG_SIZE, WI_SIZE>(q, ws.sort, all_keys, indices, size);
+    bench::track(q.memcpy(top_keys, all_keys, k * sizeof(K)));
+    bench::track(q.memcpy(top_indices, indices, k * sizeof(uint32_t)));
+}
+
+// The k largest keys in descending order and their indices, by a radix select and a sort of the k winners.
+// Of keys equal to the k-th largest, which ones are taken depends on timing.
+template<typename K, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
+void vector_top_k_select(sycl::queue &q, TopKWorkspace<K> &ws, K *keys, size_t size, size_t k,
+                         K *top_keys, uint32_t *top_indices) {
+    using namespace sort_detail;
+    static_assert(sizeof(K) == 4, "top-k selects 32-bit keys");
+    static_assert(WG_SIZE >= radix, "one work-item per digit");
+    static_assert(SG_SIZE <= 32, "ballots are read as 32-bit masks");
+    using counter_ref = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device,
+        sycl::access::address_space::global_space>;
+    constexpr size_t TILE = WG_SIZE * WI_SIZE;
+    top_k_check(size, k);
+    size_t tiles = ceil_div(size, TILE);
+    uint32_t *histogram = ws.histogram;
+    TopKState *state = ws.state;
+
+    bench::track(q.memset(histogram, 0, radix * sizeof(uint32_t)));
+    bench::track(q.single_task([=] {
+        *state = {0, static_cast<uint32_t>(k), 0, 0};
+    }));
+
+    // Descending ordered bits: the k largest keys have the k smallest bits, found from the top digit down.
+    for (int shift = 32 - radix_bits; shift >= 0; shift -= radix_bits) {
+        uint32_t high = shift + radix_bits < 32 ? ~0u << (shift + radix_bits) : 0; // the digits already chosen
+
+        bench::track(q.submit([&](sycl::handler &h) {
+            sycl::local_accessor<uint32_t, 1> hist{radix, h};
+            h.parallel_for(
+                sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+                [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                    size_t l_i = item.get_local_id(0);
+                    if (l_i < radix) hist[l_i] = 0;
+                    uint32_t prefix = state->prefix & high;
+                    item.barrier(sycl::access::fence_space::local_space);
+
+                    for (size_t j = 0; j < WI_SIZE; j++) {
+                        size_t i = item.get_group(0) * TILE + j * WG_SIZE + l_i;
+                        uint32_t bits = i < size ? ordered_bits<K, true>(keys[i]) : 0;
+                        bool candidate = i < size && (bits & high) == prefix;
+                        histogram_add(item.get_sub_group(), hist, bits >> shift & (radix - 1), candidate);
+                    }
+                    item.barrier(sycl::access::fence_space::local_space);
+                    if (l_i < radix && hist[l_i]) {
+                        counter_ref(histogram[l_i]) += hist[l_i];
+                    }
+                });
+        }));
+
+        // the digit whose bin holds the remaining-th candidate, the histogram is cleared for the next pass
+        bench::track(q.parallel_for(
+            sycl::nd_range<1>{radix, radix},
+            [=](sycl::nd_item<1> item) {
+                size_t d = item.get_local_id(0);
+                uint32_t count = histogram[d];
+                uint32_t before = sycl::exclusive_scan_over_group(item.get_group(), count, sycl::plus<uint32_t>());
+                uint32_t remaining = state->remaining;
+                item.barrier(sycl::access::fence_space::global_space);
+                if (before < remaining && remaining <= before + count) {
+                    state->prefix |= static_cast<uint32_t>(d) << shift;
+                    state->remaining = remaining - before;
+                }
+                histogram[d] = 0;
+            }));
+    }
+
+    // Keys ordered before the k-th one fill slots [0, k - remaining), the first remaining keys equal to
+    // it the rest. Each sub-group takes its slots with one atomic per kind.
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{tiles * WG_SIZE, WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            auto sg = item.get_sub_group();
+            uint32_t lane = sg.get_local_linear_id(), below = (1u << lane) - 1;
+            uint32_t kth = state->prefix, equal_slots = state->remaining;
+            uint32_t above_slots = static_cast<uint32_t>(k) - equal_slots;
+
+            for (size_t j = 0; j < WI_SIZE; j++) {
+                size_t i = item.get_group(0) * TILE + j * WG_SIZE + item.get_local_id(0);
+                uint32_t bits = i < size ? ordered_bits<K, true>(keys[i]) : ~0u;
+                bool above = i < size && bits < kth, equal = i < size && bits == kth;
+
+                uint32_t above_mask, equal_mask;
+                sycl::ext::oneapi::group_ballot(sg, above).extract_bits(above_mask);
+                sycl::ext::oneapi::group_ballot(sg, equal).extract_bits(equal_mask);
+                uint32_t above_base = 0, equal_base = 0;
+                if (lane == 0 && above_mask) {
+                    above_base = counter_ref(state->above).fetch_add(std::popcount(above_mask));
+                }
+                if (lane == 0 && equal_mask) {
+                    equal_base = counter_ref(state->equal).fetch_add(std::popcount(equal_mask));
+                }
+                above_base = sycl::group_broadcast(sg, above_base);
+                equal_base = sycl::group_broadcast(sg, equal_base);
+
+                if (above) {
+                    uint32_t slot = above_base + std::popcount(above_mask & below);
+                    top_keys[slot] = keys[i];
+                    top_indices[slot] = static_cast<uint32_t>(i);
+                }
+                if (equal) {
+                    uint32_t slot = equal_base + std::popcount(equal_mask & below);
+                    if (slot < equal_slots) {
+                        top_keys[above_slots + slot] = keys[i];
+                        top_indices[above_slots + slot] = static_cast<uint32_t>(i);
+                    }
+                }
+            }
+        }));
+
+    radix_sort_pairs<K, uint32_t, true, WG_SIZE, SG_SIZE, WI_SIZE>(q, ws.sort, top_keys, top_indices, k);
+}
@@ -0,0 +1,76 @@
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/host-parallel.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/reduction.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Launch-bound reductions: every variant is timed eagerly and as a replay of a recorded graph
+// (common/graph.hpp), at sizes small enough that host submission dominates.
+//   reduce_atomic / reduce_group_atomic_collect   single_task init + main kernel
+//   reduce_group_recursion                         one kernel per level, log(size) launches
+//   reduce_group_last_group                        single launch, the control
+
+
+int main(int argc, char *argv[]) {
+    using namespace cbu;
+    using dtype = float;
+    using Op = Sum<dtype>;
+    constexpr size_t wg_size = 256;
+    constexpr size_t sg_size = 32;
+    constexpr size_t wi_size = 4;
+
+    bench::Driver driver{argc, argv};
+    driver.set_graph_replay(true);
+    size_t size_arg = driver.arg("size", 0); // 0 runs the default sweep
+    std::vector<size_t> sizes = size_arg
+                                    ? std::vector<size_t>{size_arg}
+                                    : std::vector<size_t>{1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024};
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    size_t cu = q.get_device().get_info<sycl::info::device::max_compute_units>();
+    auto workspace = reduce_workspace_alloc<dtype>(q, cu * 4);
+
+    for (size_t size: sizes) {
+        driver.section("size " + std::to_string(size));
+
+        std::vector<dtype> vec(size), out(1);
+        random_fill(vec);
+        out[0] = bench::host_parallel_reduce(size, dtype{0}, [&](size_t begin, size_t end) {
+            return bench::host_simd_sum<dtype>(begin, end, [&](size_t i) { return vec[i]; });
+        });
+
+        auto *d_vec = pool.malloc_device<dtype>(size, q);
+        auto *d_out = pool.malloc_device<dtype>(1, q);
+        q.memcpy(d_vec, vec.data(), size * sizeof(dtype)).wait();
+
+        BenchmarkOptions opt{
+            .total_mem_bytes = size * sizeof(dtype),
+        };
+
+        using func_t = std::function<void(sycl::queue &, dtype *, size_t, Identity<dtype>, dtype *)>;
+        std::vector<std::tuple<std::string, func_t> > funcs{
+            {"reduce_atomic", reduce_atomic<Op, Identity<dtype>, dtype>},
+            {"reduce_group_atomic_collect", reduce_group_atomic_collect<Op, wg_size, sg_size, Identity<dtype>, dtype>},
+            {"reduce_group_recursion", reduce_group_recursion<Op, wg_size, sg_size, Identity<dtype>, dtype>},
+            {
+                "reduce_group_last_group",
+                [&](sycl::queue &q, dtype *out, size_t size, Identity<dtype> f, dtype *vec) {
+                    reduce_group_last_group<Op, wg_size, sg_size, wi_size>(q, workspace, out, size, f, vec);
+                }
+            },
+        };
+
+        driver.run_all(funcs, opt,
+                       [&](func_t &func) { func(q, d_out, size, Identity<dtype>{}, d_vec); },
+                       [&] { q.fill(d_out, dtype{0}, 1).wait(); },
+                       [&] { sycl_acc_check(q, out, d_out); });
+
+        pool.free(d_vec, q);
+        pool.free(d_out, q);
+    }
+
+    reduce_workspace_free(q, workspace);
+}
@@ -0,0 +1,251 @@
+#include <sycl/sycl.hpp>
+#include <oneapi/mkl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/host-parallel.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-multiply.hpp"
+#include "005-matrix/matrix-vector-multiply.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Many small products per call: one launch per problem versus one launch for the whole batch.
+// GEMM: batch x ([m,k] x [k,n]), A and C row-major, B row-major or col-major.
+// GEMV: batch x ([m,n] x [n]), A row-major or col-major.
+// Problems are packed back to back, so the strides are the matrix/vector sizes.
+
+template<typename T, cbu::matrix_layout a_layout>
+void matrix_vector_multiply_batch_strided_mkl(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n,
+                                              size_t batch, size_t stride_a, size_t stride_b, size_t stride_c) {
+    using namespace cbu;
+    if constexpr (a_layout == matrix_layout::row_major) {
+        bench::track(oneapi::mkl::blas::row_major::gemv_batch(
+            q, oneapi::mkl::transpose::nontrans, m, n, static_cast<T>(1),
+            a, n, stride_a, b, 1, stride_b, static_cast<T>(0), c, 1, stride_c, batch));
+    } else {
+        bench::track(oneapi::mkl::blas::column_major::gemv_batch(
+            q, oneapi::mkl::transpose::nontrans, m, n, static_cast<T>(1),
+            a, m, stride_a, b, 1, stride_b, static_cast<T>(0), c, 1, stride_c, batch));
+    }
+}
+
+// Device array of pointers base + p * stride for the pointer-array entry points.
+template<typename T>
+T **make_batch_ptrs(sycl::queue &q, T *base, size_t stride, size_t batch) {
+    std::vector<T *> ptrs(batch);
+    for (size_t p = 0; p < batch; p++) {
+        ptrs[p] = base + p * stride;
+    }
+    T **d_ptrs = bench::usm_pool().malloc_device<T *>(batch, q);
+    q.memcpy(d_ptrs, ptrs.data(), batch * sizeof(T *)).wait();
+    return d_ptrs;
+}
+
+template<cbu::matrix_layout b_layout>
+void test_matrix_multiply_batch(bench::Driver &driver) {
+    using namespace cbu;
+    std::string b_major = b_layout == matrix_layout::row_major ? "row major" : "col major";
+    driver.section("gemm batch, matrix b in " + b_major);
+
+    using dtype = float;
+    constexpr size_t wg_size = 16;
+    constexpr size_t sg_size = 16;
+
+    size_t batch = driver.arg("batch", 1024);
+    size_t m = driver.arg("m", 64), n = driver.arg("n", 64), k = driver.arg("k", 64);
+    size_t stride_a = m * k, stride_b = k * n, stride_c = m * n;
+
+    std::vector<dtype> a(batch * stride_a), b(batch * stride_b), c(batch * stride_c);
+    random_fill(a);
+    random_fill(b);
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = batch * (stride_a + stride_b + stride_c) * sizeof(dtype),
+        .total_flop = batch * 2 * m * n * k,
+    };
+    driver.run_ref("matrix_multiply_batch_ref", [&]() {
+        // one problem per task, each with its own operand copies
+        bench::host_parallel_for(batch, [&](size_t begin, size_t end) {
+            std::vector<dtype> a_p(stride_a), b_p(stride_b), c_p(stride_c);
+            for (size_t p = begin; p < end; p++) {
+                std::copy_n(a.begin() + p * stride_a, stride_a, a_p.begin());
+                std::copy_n(b.begin() + p * stride_b, stride_b, b_p.begin());
+                matrix_multiply_ref<dtype, b_layout>(a_p, b_p, c_p, m, n, k);
+                std::copy_n(c_p.begin(), stride_c, c.begin() + p * stride_c);
+            }
+        }, 1);
+    }, opt);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_a = pool.malloc_device<dtype>(a.size(), q);
+    auto *d_b = pool.malloc_device<dtype>(b.size(), q);
+    auto *d_c = pool.malloc_device<dtype>(c.size(), q);
+    q.memcpy(d_a, a.data(), a.size() * sizeof(dtype)).wait();
+    q.memcpy(d_b, b.data(), b.size() * sizeof(dtype)).wait();
+
+    dtype **d_a_ptrs = make_batch_ptrs(q, d_a, stride_a, batch);
+    dtype **d_b_ptrs = make_batch_ptrs(q, d_b, stride_b, batch);
+    dtype **d_c_ptrs = make_batch_ptrs(q, d_c, stride_c, batch);
+
+    using func_t = std::function<void(sycl::queue &)>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {
+            "matrix_multiply_loop_nd_range_slm",
+            [&](sycl::queue &q) {
+                for (size_t p = 0; p < batch; p++) {
+                    matrix_multiply_nd_range_slm<dtype, wg_size, sg_size, b_layout>(
+                        q, d_a + p * stride_a, d_b + p * stride_b, d_c + p * stride_c, m, n, k);
+                }
+            }
+        },
+        {
+            "matrix_multiply_loop_mkl",
+            [&](sycl::queue &q) {
+                for (size_t p = 0; p < batch; p++) {
+                    matrix_multiply_mkl<dtype, b_layout>(
+                        q, d_a + p * stride_a, d_b + p * stride_b, d_c + p * stride_c, m, n, k);
+                }
+            }
+        },
+        {
+            "matrix_multiply_batch_strided_slm",
+            [&](sycl::queue &q) {
+                matrix_multiply_batch_strided_slm<dtype, wg_size, sg_size, b_layout>(
+                    q, d_a, d_b, d_c, m, n, k, batch, stride_a, stride_b, stride_c);
+            }
+        },
+        {
+            "matrix_multiply_batch_ptr_slm",
+            [&](sycl::queue &q) {
+                matrix_multiply_batch_ptr_slm<dtype, wg_size, sg_size, b_layout>(
+                    q, d_a_ptrs, d_b_ptrs, d_c_ptrs, m, n, k, batch);
+            }
+        },
+        {
+            "matrix_multiply_batch_strided_mkl",
+            [&](sycl::queue &q) {
+                matrix_multiply_batch_strided_mkl<dtype, b_layout>(
+                    q, d_a, d_b, d_c, m, n, k, batch, stride_a, stride_b, stride_c);
+            }
+        },
+    };
+
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q); },
+                   [&] { q.fill(d_c, dtype{0}, c.size()).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    pool.free(d_a_ptrs, q);
+    pool.free(d_b_ptrs, q);
+    pool.free(d_c_ptrs, q);
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
+}
+
+template<cbu::matrix_layout a_layout>
+void test_matrix_vector_multiply_batch(bench::Driver &driver) {
+    using namespace cbu;
+    std::string a_major = a_layout == matrix_layout::row_major ? "row major" : "col major";
+    driver.section("gemv batch, matrix a in " + a_major);
+
+    using dtype = float;
+    constexpr size_t wg_size = 32;
+    constexpr size_t sg_size = 32;
+
+    size_t batch = driver.arg("batch", 1024);
+    size_t m = driver.arg("gemv_m", 256), n = driver.arg("gemv_n", 256);
+    size_t stride_a = m * n, stride_b = n, stride_c = m;
+
+    std::vector<dtype> a(batch * stride_a), b(batch * stride_b), c(batch * stride_c);
+    random_fill(a);
+    random_fill(b);
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = batch * (stride_a + stride_b + stride_c) * sizeof(dtype),
+        .total_flop = batch * 2 * m * n,
+    };
+    driver.run_ref("matrix_vector_multiply_batch_ref", [&]() {
+        size_t ld = a_layout == matrix_layout::row_major ? n : m;
+        // rows of all problems on all host threads
+        bench::host_parallel_for(batch * m, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                size_t p = r / m, i = r % m;
+                dtype *a_p = a.data() + p * stride_a, *b_p = b.data() + p * stride_b;
+                dtype sum = 0;
+                for (size_t j = 0; j < n; j++) {
+                    sum += (a_layout == matrix_layout::row_major ? mat(a_p, ld, i, j) : mat(a_p, ld, j, i)) * b_p[j];
+                }
+                c[p * stride_c + i] = sum;
+            }
+        }, 64);
+    }, opt);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_a = pool.malloc_device<dtype>(a.size(), q);
+    auto *d_b = pool.malloc_device<dtype>(b.size(), q);
+    auto *d_c = pool.malloc_device<dtype>(c.size(), q);
+    q.memcpy(d_a, a.data(), a.size() * sizeof(dtype)).wait();
+    q.memcpy(d_b, b.data(), b.size() * sizeof(dtype)).wait();
+
+    dtype **d_a_ptrs = make_batch_ptrs(q, d_a, stride_a, batch);
+    dtype **d_b_ptrs = make_batch_ptrs(q, d_b, stride_b, batch);
+    dtype **d_c_ptrs = make_batch_ptrs(q, d_c, stride_c, batch);
+
+    using func_t = std::function<void(sycl::queue &)>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {
+            "matrix_vector_multiply_loop_row_split_sg",
+            [&](sycl::queue &q) {
+                for (size_t p = 0; p < batch; p++) {
+                    matrix_vector_multiply_row_split_sg<dtype, a_layout, wg_size, sg_size>(
+                        q, d_a + p * stride_a, d_b + p * stride_b, d_c + p * stride_c, m, n);
+                }
+            }
+        },
+        {
+            "matrix_vector_multiply_batch_strided_row_split_sg",
+            [&](sycl::queue &q) {
+                matrix_vector_multiply_batch_strided_row_split_sg<dtype, a_layout, wg_size, sg_size>(
+                    q, d_a, d_b, d_c, m, n, batch, stride_a, stride_b, stride_c);
+            }
+        },
+        {
+            "matrix_vector_multiply_batch_ptr_row_split_sg",
+            [&](sycl::queue &q) {
+                matrix_vector_multiply_batch_ptr_row_split_sg<dtype, a_layout, wg_size, sg_size>(
+                    q, d_a_ptrs, d_b_ptrs, d_c_ptrs, m, n, batch);
+            }
+        },
+        {
+            "matrix_vector_multiply_batch_strided_mkl",
+            [&](sycl::queue &q) {
+                matrix_vector_multiply_batch_strided_mkl<dtype, a_layout>(
+                    q, d_a, d_b, d_c, m, n, batch, stride_a, stride_b, stride_c);
+            }
+        },
+    };
+
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q); },
+                   [&] { q.fill(d_c, dtype{0}, c.size()).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    pool.free(d_a_ptrs, q);
+    pool.free(d_b_ptrs, q);
+    pool.free(d_c_ptrs, q);
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
+}
+
+
+int main(int argc, char *argv[]) {
+    bench::Driver driver{argc, argv};
+    test_matrix_multiply_batch<cbu::matrix_layout::row_major>(driver);
+    test_matrix_multiply_batch<cbu::matrix_layout::col_major>(driver);
+    test_matrix_vector_multiply_batch<cbu::matrix_layout::row_major>(driver);
+    test_matrix_vector_multiply_batch<cbu::matrix_layout::col_major>(driver);
+}
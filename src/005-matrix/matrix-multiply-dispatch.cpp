@@ -0,0 +1,86 @@
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-multiply-dispatch.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// gemm() against every path it could pick on this device, with oneMKL as the baseline:
+//   float              A, B and C in float
+//   half -> float      A and B in half, C accumulated in float
+// The log shows what the device reports and which path gemm() takes for --m --n --k.
+
+template<typename T, typename Tc, cbu::matrix_layout b_layout>
+void test_gemm(bench::Driver &driver, const std::string &types) {
+    using namespace cbu;
+    std::string b_major = b_layout == matrix_layout::row_major ? "row major" : "col major";
+    driver.section(types + ", matrix b in " + b_major);
+
+    size_t m = driver.arg("m", 2 * 1024), n = driver.arg("n", 512), k = driver.arg("k", 1024);
+
+    std::vector<T> a(m * k), b(k * n);
+    random_fill(a);
+    random_fill(b);
+
+    // the reference runs on the inputs converted to Tc
+    std::vector<Tc> a_ref(a.begin(), a.end()), b_ref(b.begin(), b.end()), c(m * n);
+    BenchmarkOptions opt{
+        .total_mem_bytes = (m * k + k * n) * sizeof(T) + m * n * sizeof(Tc),
+        .total_flop = 2 * m * n * k,
+    };
+    driver.run_ref("matrix_multiply_ref", [&]() {
+        matrix_multiply_host_ref<Tc, b_layout>(a_ref.data(), b_ref.data(), c.data(), m, n, k);
+    }, opt);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_a = pool.malloc_device<T>(a.size(), q);
+    auto *d_b = pool.malloc_device<T>(b.size(), q);
+    auto *d_c = pool.malloc_device<Tc>(c.size(), q);
+    q.memcpy(d_a, a.data(), a.size() * sizeof(T)).wait();
+    q.memcpy(d_b, b.data(), b.size() * sizeof(T)).wait();
+
+    GemmPlan plan = gemm_plan<T, Tc>(q.get_device());
+    driver.log() << "\tjoint_matrix tile: "
+        << (plan.joint_tn ? "8x" + std::to_string(plan.joint_tn) + "x16" : std::string("none"))
+        << ", slm_reg_tile sub-group: " << (plan.slm_sg_size ? std::to_string(plan.slm_sg_size) : "none")
+        << (plan.slm_sg_size ? (plan.slm_faster ? " (faster than mkl)" : " (slower than mkl)") : "")
+        << ", gemm path: " << to_string(choose_gemm_path(plan, m, n, k)) << "\n";
+
+    auto reset = [&] { q.fill(d_c, Tc{0}, c.size()).wait(); };
+    auto check = [&] { sycl_acc_check(q, c, d_c); };
+
+    reset();
+    driver.run("gemm_mkl", [&] {
+        gemm<T, b_layout, Tc>(q, gemm_path::mkl, d_a, d_b, d_c, m, n, k);
+        q.wait();
+    }, opt, check);
+    driver.baseline("gemm_mkl");
+
+    using func_t = std::function<void(sycl::queue &)>;
+    std::vector<std::tuple<std::string, func_t> > funcs;
+    for (gemm_path path: {gemm_path::slm_reg_tile, gemm_path::joint_matrix}) {
+        if (!gemm_path_supported(plan, path, m, n, k)) continue;
+        funcs.emplace_back("gemm_" + to_string(path), [&, path](sycl::queue &q) {
+            gemm<T, b_layout, Tc>(q, path, d_a, d_b, d_c, m, n, k);
+        });
+    }
+    funcs.emplace_back("gemm", [&](sycl::queue &q) { gemm<T, b_layout, Tc>(q, d_a, d_b, d_c, m, n, k); });
+
+    driver.run_all(funcs, opt, [&](func_t &func) { func(q); }, reset, check);
+
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
+}
+
+
+int main(int argc, char *argv[]) {
+    using cbu::matrix_layout;
+
+    bench::Driver driver{argc, argv};
+    test_gemm<float, float, matrix_layout::row_major>(driver, "float");
+    test_gemm<float, float, matrix_layout::col_major>(driver, "float");
+    test_gemm<sycl::half, float, matrix_layout::row_major>(driver, "half -> float");
+    test_gemm<sycl::half, float, matrix_layout::col_major>(driver, "half -> float");
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sycl/sycl.hpp>
+#include <oneapi/mkl.hpp>
+
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-multiply.hpp"
+#include "005-matrix/matrix-multiply-xmx.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// gemm(): one entry point for C = A x B (layouts as matrix-multiply.hpp, C accumulated in Tc) that picks the
+// kernel from what the device reports instead of assuming it:
+//   joint_matrix   a matrix_combinations entry matches the types and one of the compiled tiles (XMX, or AMX
+//                  on CPUs), and m, n, k are multiples of the work-group tile
+//   slm_reg_tile   a non-CPU device with sub-group size 16 or 32, a 256 work-item work-group and the SLM for
+//                  the tiles, with A, B and C of one type, and a timed probe showed it faster than oneMKL
+//   mkl            everything else, including CPU devices without AMX
+// The device part of the decision, probe included, is made once per device and type pair and cached, only
+// the shape checks run per call.
+
+enum class gemm_path { joint_matrix, slm_reg_tile, mkl };
+
+inline std::string to_string(gemm_path path) {
+    switch (path) {
+        case gemm_path::joint_matrix: return "joint_matrix";
+        case gemm_path::slm_reg_tile: return "slm_reg_tile";
+        default: return "mkl";
+    }
+}
+
+struct GemmPlan {
+    size_t joint_tn = 0; // N of the matching joint_matrix tile, 0 if none
+    size_t slm_sg_size = 0; // sub-group size of slm_reg_tile, 0 if it cannot run
+    bool slm_faster = false; // slm_reg_tile beat oneMKL in the probe, so gemm() picks it over mkl
+};
+
+namespace gemm_detail {
+    // joint_matrix tiles: TM x TN x TK per sub-group, a work-group of WG_T_NUM x WG_T_NUM sub-groups.
+    constexpr size_t joint_wg_t_num = 4, joint_tm = 8, joint_tk = 16;
+    constexpr size_t joint_tn[] = {16, 8}; // PVC, DG2
+
+    // slm_reg_tile: 64 x 64 blocks, 16-deep k tiles, 4 x 4 micro-tiles, so 16 x 16 work-items.
+    constexpr size_t slm_bm = 64, slm_bn = 64, slm_bk = 16, slm_tm = 4, slm_tn = 4;
+    constexpr size_t slm_wg_items = slm_bm / slm_tm * (slm_bn / slm_tn);
+
+    template<typename T>
+    constexpr bool joint_matrix_input = std::is_same_v<T, sycl::half> || std::is_same_v<T, sycl::ext::oneapi::bfloat16>;
+
+    template<typename T>
+    constexpr xmx::matrix_type matrix_type_of() {
+        if constexpr (std::is_same_v<T, sycl::half>) return xmx::matrix_type::fp16;
+        else if constexpr (std::is_same_v<T, sycl::ext::oneapi::bfloat16>) return xmx::matrix_type::bf16;
+        else if constexpr (std::is_same_v<T, double>) return xmx::matrix_type::fp64;
+        else return xmx::matrix_type::fp32;
+    }
+
+    // Intel GPUs report exact sizes, AMX reports size 0 and a maximum.
+    inline bool tile_fits(size_t size, size_t max_size, size_t tile) {
+        return size == tile || (size == 0 && tile <= max_size);
+    }
+}
+
+// Row-major oneMKL gemm with mixed precision (e.g. half inputs, float C); B in col_major is passed as transposed.
+template<typename T, cbu::matrix_layout b_layout, typename Tc = T>
+void gemm_mkl(sycl::queue &q, T *a, T *b, Tc *c, size_t m, size_t n, size_t k) {
+    constexpr bool b_row = b_layout == cbu::matrix_layout::row_major;
+    bench::track(oneapi::mkl::blas::row_major::gemm(
+        q,
+        oneapi::mkl::transpose::nontrans,
+        b_row ? oneapi::mkl::transpose::nontrans : oneapi::mkl::transpose::trans,
+        m, n, k,
+        static_cast<Tc>(1),
+        a, k,
+        b, b_row ? n : k,
+        static_cast<Tc>(0),
+        c, n));
+}
+
+template<typename T, typename Tc>
+GemmPlan plan_gemm(const sycl::device &device) {
+    using namespace gemm_detail;
+    GemmPlan plan;
+    if constexpr (joint_matrix_input<T>) {
+        namespace info = sycl::ext::oneapi::experimental::info;
+        std::vector<xmx::combination> combinations;
+        try {
+            combinations = device.get_info<info::device::matrix_combinations>();
+        } catch (const sycl::exception &) {
+            // backends without the matrix extension
+        }
+        for (size_t tn: joint_tn) {
+            for (auto &comb: combinations) {
+                if (comb.atype == matrix_type_of<T>() && comb.btype == matrix_type_of<T>()
+                    && comb.ctype == matrix_type_of<Tc>() && comb.dtype == matrix_type_of<Tc>()
+                    && tile_fits(comb.msize, comb.max_msize, joint_tm) && tile_fits(comb.nsize, comb.max_nsize, tn)
+                    && tile_fits(comb.ksize, comb.max_ksize, joint_tk)) {
+                    plan.joint_tn = tn;
+                    break;
+                }
+            }
+            if (plan.joint_tn) break;
+        }
+    }
+    if constexpr (std::is_same_v<T, Tc>) {
+        auto sg_sizes = device.get_info<sycl::info::device::sub_group_sizes>();
+        size_t slm_bytes = (slm_bk * (slm_bm + 1) + slm_bk * slm_bn) * sizeof(T);
+        if (!device.is_cpu() && device.get_info<sycl::info::device::max_work_group_size>() >= slm_wg_items
+            && device.get_info<sycl::info::device::local_mem_size>() >= slm_bytes) {
+            for (size_t sg: {16, 32}) {
+                if (std::find(sg_sizes.begin(), sg_sizes.end(), sg) != sg_sizes.end()) {
+                    plan.slm_sg_size = sg;
+                    break;
+                }
+            }
+        }
+    }
+    return plan;
+}
+
+// Whether slm_reg_tile beats oneMKL on the device: best of a few runs of each on a probe_size^3 problem
+// on a queue of its own. A path that fails to run loses; if slm_reg_tile fails it is also disabled.
+template<typename T>
+bool probe_slm_faster(const sycl::device &device, GemmPlan &plan, size_t probe_size = 1024) {
+    using namespace gemm_detail;
+    sycl::queue q{device, sycl::property::queue::in_order()};
+    size_t size = probe_size * probe_size;
+    auto &pool = bench::usm_pool();
+    T *a = pool.malloc_device<T>(size, q);
+    T *b = pool.malloc_device<T>(size, q);
+    T *c = pool.malloc_device<T>(size, q);
+    q.fill(a, T{1}, size);
+    q.fill(b, T{1}, size).wait();
+
+    auto best_ms = [&](auto &&submit) {
+        double best = std::numeric_limits<double>::max();
+        try {
+            submit(); // JIT
+            q.wait();
+            for (int r = 0; r < 3; r++) {
+                auto start = std::chrono::steady_clock::now();
+                submit();
+                q.wait();
+                best = std::min(best, std::chrono::duration<double, std::milli>(
+                                          std::chrono::steady_clock::now() - start).count());
+            }
+        } catch (const std::exception &) {
+            // unsupported on this device, counts as slowest
+        }
+        return best;
+    };
+    double slm_ms = best_ms([&] {
+        if (plan.slm_sg_size == 16) {
+            matrix_multiply_nd_range_slm_reg_tile<T, slm_bm, slm_bn, slm_bk, slm_tm, slm_tn, 16,
+                cbu::matrix_layout::row_major>(q, a, b, c, probe_size, probe_size, probe_size);
+        } else {
+            matrix_multiply_nd_range_slm_reg_tile<T, slm_bm, slm_bn, slm_bk, slm_tm, slm_tn, 32,
+                cbu::matrix_layout::row_major>(q, a, b, c, probe_size, probe_size, probe_size);
+        }
+    });
+    double mkl_ms = best_ms([&] {
+        gemm_mkl<T, cbu::matrix_layout::row_major, T>(q, a, b, c, probe_size, probe_size, probe_size);
+    });
+    pool.free(a, q);
+    pool.free(b, q);
+    pool.free(c, q);
+
+    if (slm_ms == std::numeric_limits<double>::max()) plan.slm_sg_size = 0;
+    return slm_ms < mkl_ms;
+}
+
+// plan_gemm() cached per device, the device queries and the probe are not free. Returned by value: the cache may
+// grow (and reallocate) while a caller still uses its plan.
+template<typename T, typename Tc>
+GemmPlan gemm_plan(const sycl::device &device) {
+    static std::mutex mutex;
+    static std::vector<std::pair<sycl::device, GemmPlan> > plans;
+    std::lock_guard lock{mutex};
+    for (auto &[d, plan]: plans) {
+        if (d == device) return plan;
+    }
+    GemmPlan plan = plan_gemm<T, Tc>(device);
+    if constexpr (std::is_same_v<T, Tc>) {
+        if (plan.slm_sg_size) plan.slm_faster = probe_slm_faster<T>(device, plan);
+    }
+    plans.emplace_back(device, plan);
+    return plan;
+}
+
+inline bool gemm_path_supported(const GemmPlan &plan, gemm_path path, size_t m, size_t n, size_t k) {
+    using namespace gemm_detail;
+    switch (path) {
+        case gemm_path::joint_matrix:
+            return plan.joint_tn && m % (joint_tm * joint_wg_t_num) == 0 && n % (plan.joint_tn * joint_wg_t_num) == 0
+                   && k % joint_tk == 0;
+        case gemm_path::slm_reg_tile:
+            return plan.slm_sg_size != 0;
+        default:
+            return true;
+    }
+}
+
+// joint_matrix when it fits, slm_reg_tile only where the probe measured it faster, oneMKL otherwise.
+inline gemm_path choose_gemm_path(const GemmPlan &plan, size_t m, size_t n, size_t k) {
+    if (gemm_path_supported(plan, gemm_path::joint_matrix, m, n, k)) return gemm_path::joint_matrix;
+    if (plan.slm_faster && gemm_path_supported(plan, gemm_path::slm_reg_tile, m, n, k)) {
+        return gemm_path::slm_reg_tile;
+    }
+    return gemm_path::mkl;
+}
+
+// Runs the given path, which must be gemm_path_supported() for the plan of q's device.
+template<typename T, cbu::matrix_layout b_layout, typename Tc = T>
+void gemm(sycl::queue &q, gemm_path path, T *a, T *b, Tc *c, size_t m, size_t n, size_t k) {
+    using namespace gemm_detail;
+    GemmPlan plan = gemm_plan<T, Tc>(q.get_device());
+    if (!gemm_path_supported(plan, path, m, n, k)) {
+        throw std::invalid_argument("gemm path " + to_string(path) + " is not supported on this device or shape");
+    }
+    if (path == gemm_path::joint_matrix) {
+        if constexpr (joint_matrix_input<T>) {
+            constexpr auto xmx_b = b_layout == cbu::matrix_layout::row_major ? xmx::layout::row_major
+                                                                             : xmx::layout::col_major;
+            if (plan.joint_tn == 16) {
+                matrix_multiply_joint<T, Tc, xmx_b, joint_wg_t_num, joint_tm, 16, joint_tk>(q, a, b, c, m, n, k);
+            } else {
+                matrix_multiply_joint<T, Tc, xmx_b, joint_wg_t_num, joint_tm, 8, joint_tk>(q, a, b, c, m, n, k);
+            }
+            return;
+        }
+    }
+    if (path == gemm_path::slm_reg_tile) {
+        if constexpr (std::is_same_v<T, Tc>) {
+            if (plan.slm_sg_size == 16) {
+                matrix_multiply_nd_range_slm_reg_tile<T, slm_bm, slm_bn, slm_bk, slm_tm, slm_tn, 16, b_layout>(
+                    q, a, b, c, m, n, k);
+            } else {
+                matrix_multiply_nd_range_slm_reg_tile<T, slm_bm, slm_bn, slm_bk, slm_tm, slm_tn, 32, b_layout>(
+                    q, a, b, c, m, n, k);
+            }
+            return;
+        }
+    }
+    gemm_mkl<T, b_layout, Tc>(q, a, b, c, m, n, k);
+}
+
+// Picks the path from the device capabilities and the shape, and returns it.
+template<typename T, cbu::matrix_layout b_layout, typename Tc = T>
+gemm_path gemm(sycl::queue &q, T *a, T *b, Tc *c, size_t m, size_t n, size_t k) {
+    gemm_path path = choose_gemm_path(gemm_plan<T, Tc>(q.get_device()), m, n, k);
+    gemm<T, b_layout, Tc>(q, path, a, b, c, m, n, k);
+    return path;
+}
@@ -0,0 +1,158 @@
+#include <sstream>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/multi-device.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-multiply.hpp"
+#include "005-matrix/matrix-vector-multiply.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// GEMM and row-major GEMV with the rows of A and C split over several devices (common/multi-device.hpp).
+//   --devices=all            every device from sycl::device::get_devices() (default)
+//   --devices=<spec,spec>    a list of --device style specs, e.g. --devices=gpu,cpu or --devices=0,2
+//   --sub_devices=<n>        n equal sub-devices of --device instead, e.g. --device=cpu --sub_devices=4
+//   --kernel=<slm|mkl>       GEMM kernel run on every slice (default slm)
+// Each device is first run alone; its rows/s becomes its share of the partitioned run.
+
+std::vector<sycl::device> partition_devices(bench::Driver &driver) {
+    size_t sub_devices = driver.arg("sub_devices", 0);
+    if (sub_devices) {
+        return bench::split_device(driver.queue().get_device(), sub_devices);
+    }
+
+    std::string spec = driver.option("devices", "all");
+    if (spec == "all") {
+        return sycl::device::get_devices();
+    }
+    std::vector<sycl::device> devices;
+    std::stringstream ss(spec);
+    for (std::string item; std::getline(ss, item, ',');) {
+        devices.push_back(bench::select_device(item));
+    }
+    return devices;
+}
+
+template<typename T>
+void run_partitioned(bench::Driver &driver, bench::RowPartitioner<T> &partitioner,
+                     const typename bench::RowPartitioner<T>::kernel_t &kernel,
+                     const std::vector<T> &in, const std::vector<T> &shared, std::vector<T> &out,
+                     std::vector<T> &out_ref, size_t rows, const cbu::BenchmarkOptions &opt) {
+    using namespace cbu;
+    sycl::queue &q = driver.queue();
+    auto check = [&] {
+        sycl_acc_check(q, out_ref, out.data());
+        std::fill(out.begin(), out.end(), T{0});
+    };
+
+    partitioner.calibrate(kernel, in.data(), shared.data(), std::min<size_t>(rows, 1024), 3, &driver.log());
+    std::vector<double> throughput = partitioner.throughput();
+    std::vector<size_t> parts = partitioner.split(rows);
+    size_t fastest = std::max_element(throughput.begin(), throughput.end()) - throughput.begin();
+
+    for (size_t i = 0; i < partitioner.size(); i++) {
+        driver.log() << "\t[" << i << "] " << partitioner.device_name(i) << ": "
+                << static_cast<size_t>(throughput[i]) << " rows/s, " << parts[i] << " rows\n";
+    }
+
+    // every device alone, then all of them with the measured split
+    for (size_t i = 0; i < partitioner.size(); i++) {
+        if (throughput[i] == 0) continue;
+        std::vector<double> alone(partitioner.size(), 0.0);
+        alone[i] = 1;
+        partitioner.set_throughput(alone);
+        std::string name = "single device [" + std::to_string(i) + "] " + partitioner.device_name(i);
+        driver.run(name, [&] { partitioner.run(kernel, in.data(), shared.data(), out.data(), rows); }, opt, check);
+        if (i == fastest) driver.baseline(name);
+    }
+
+    partitioner.set_throughput(throughput);
+    driver.run("partitioned - " + std::to_string(partitioner.size()) + " devices", [&] {
+        partitioner.run(kernel, in.data(), shared.data(), out.data(), rows);
+    }, opt, check);
+}
+
+template<cbu::matrix_layout b_layout>
+void test_matrix_multiply_multi_device(bench::Driver &driver, const std::vector<sycl::device> &devices) {
+    using namespace cbu;
+    std::string b_major = b_layout == matrix_layout::row_major ? "row major" : "col major";
+    driver.section("partitioned gemm, matrix b in " + b_major);
+
+    using dtype = float;
+    constexpr size_t wg_size = 16;
+    constexpr size_t sg_size = 16;
+
+    size_t m = driver.arg("m", 4 * 1024), n = driver.arg("n", 1024), k = driver.arg("k", 1024);
+    std::string kernel_name = driver.option("kernel", "slm");
+
+    std::vector<dtype> a(m * k), b(k * n), c(m * n), c_ref(m * n);
+    random_fill(a);
+    random_fill(b);
+
+    // transfers are part of every variant
+    BenchmarkOptions opt{
+        .total_mem_bytes = (m * k + k * n + m * n) * sizeof(dtype),
+        .total_flop = 2 * m * n * k,
+    };
+    driver.run_ref("matrix_multiply_ref", [&]() {
+        matrix_multiply_host_ref<dtype, b_layout>(a.data(), b.data(), c_ref.data(), m, n, k);
+    }, opt);
+
+    typename bench::RowPartitioner<dtype>::kernel_t kernel;
+    if (kernel_name == "mkl") {
+        // row_major::gemm (B col-major as transposed): a slice is rows x k of A and rows x n of C with the full
+        // matrix's leading dims, so it must not go through column_major::gemm, whose ld would be the slice height.
+        kernel = [=](sycl::queue &q, dtype *a, dtype *b, dtype *c, size_t rows) {
+            matrix_multiply_mkl<dtype, b_layout>(q, a, b, c, rows, n, k);
+        };
+    } else if (kernel_name == "slm") {
+        kernel = [=](sycl::queue &q, dtype *a, dtype *b, dtype *c, size_t rows) {
+            matrix_multiply_nd_range_slm<dtype, wg_size, sg_size, b_layout>(q, a, b, c, rows, n, k);
+        };
+    } else {
+        throw std::invalid_argument("Unknown kernel: " + kernel_name);
+    }
+
+    bench::RowPartitioner<dtype> partitioner{bench::make_queues(devices, driver.queue()), k, k * n, n, wg_size};
+    run_partitioned(driver, partitioner, kernel, a, b, c, c_ref, m, opt);
+}
+
+void test_matrix_vector_multiply_multi_device(bench::Driver &driver, const std::vector<sycl::device> &devices) {
+    using namespace cbu;
+    driver.section("partitioned gemv, matrix a in row major");
+
+    using dtype = float;
+    constexpr size_t wg_size = 256;
+    constexpr size_t sg_size = 16;
+
+    size_t m = driver.arg("gemv_m", 256 * 1024), n = driver.arg("gemv_n", 1024);
+
+    std::vector<dtype> a(m * n), b(n), c(m), c_ref(m);
+    random_fill(a);
+    random_fill(b);
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = (m * n + n + m) * sizeof(dtype),
+        .total_flop = 2 * m * n,
+    };
+    driver.run_ref("matrix_vector_multiply_ref", [&]() {
+        matrix_vector_multiply_ref<dtype, matrix_layout::row_major>(a.data(), b.data(), c_ref.data(), m, n);
+    }, opt);
+
+    typename bench::RowPartitioner<dtype>::kernel_t kernel = [=](sycl::queue &q, dtype *a, dtype *b, dtype *c,
+                                                                 size_t rows) {
+        matrix_vector_multiply_row_split_wg<dtype, matrix_layout::row_major, wg_size, sg_size>(q, a, b, c, rows, n);
+    };
+
+    bench::RowPartitioner<dtype> partitioner{bench::make_queues(devices, driver.queue()), n, n, 1, 1};
+    run_partitioned(driver, partitioner, kernel, a, b, c, c_ref, m, opt);
+}
+
+
+int main(int argc, char *argv[]) {
+    bench::Driver driver{argc, argv};
+    std::vector<sycl::device> devices = partition_devices(driver);
+    test_matrix_multiply_multi_device<cbu::matrix_layout::row_major>(driver, devices);
+    test_matrix_multiply_multi_device<cbu::matrix_layout::col_major>(driver, devices);
+    test_matrix_vector_multiply_multi_device(driver, devices);
+}
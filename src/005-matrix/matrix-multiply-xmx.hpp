@@ -0,0 +1,72 @@
+#pragma once
+
+#include <sycl/sycl.hpp>
+
+#include "common/profiling.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// A : [m,k] in row-major
+// B : [k,n] in row-major or col-major
+// C = A x B : [m,n] in row-major, accumulated in acc_type by joint_matrix (XMX on Intel GPUs, AMX on CPUs)
+
+namespace xmx = sycl::ext::oneapi::experimental::matrix;
+
+template <typename KernelName>
+size_t get_sg_size(sycl::queue& q)
+{
+    auto KernelID = sycl::get_kernel_id<KernelName>();
+    auto KB = get_kernel_bundle<sycl::bundle_state::executable>(q.get_context(), {KernelID});
+    auto kernel = KB.get_kernel(KernelID);
+    return kernel.template get_info<sycl::info::kernel_device_specific::max_sub_group_size>(q.get_device());
+}
+
+template <typename dtype, typename acc_type, xmx::layout b_layout, size_t WG_T_NUM, size_t TM, size_t TN, size_t TK>
+struct matrix_multiply_joint_kernel;
+
+template <typename dtype, typename acc_type, xmx::layout b_layout, size_t WG_T_NUM, size_t TM, size_t TN, size_t TK>
+void matrix_multiply_joint(sycl::queue& q, dtype* a, dtype* b, acc_type* c, size_t m, size_t n, size_t k)
+{
+    using namespace cbu;
+    check_divisible(m, TM * WG_T_NUM, "M must be divisible by TM * WG_T_NUM");
+    check_divisible(n, TN * WG_T_NUM, "N must be divisible by TN * WG_T_NUM");
+    check_divisible(k, TK, "K must be divisible by TK");
+
+    using kernel_name = matrix_multiply_joint_kernel<dtype, acc_type, b_layout, WG_T_NUM, TM, TN, TK>;
+
+    size_t lda = k, ldb = b_layout == xmx::layout::row_major ? n : k, ldc = n;
+    size_t sg_size = get_sg_size<kernel_name>(q);
+    sycl::range<2> local = {WG_T_NUM, WG_T_NUM * sg_size}; // WG_T_NUM * WG_T_NUM tiles
+    sycl::range<2> global = {m / (TM * WG_T_NUM), n / (TN * WG_T_NUM)};
+    global *= local;
+
+    bench::track(q.parallel_for<kernel_name>(
+        sycl::nd_range<2>{global, local},
+        [=](sycl::nd_item<2> item)
+        {
+            sycl::sub_group sg = item.get_sub_group();
+            size_t g_i = item.get_global_id(0);
+            size_t g_j = item.get_global_id(1) / sg_size;
+
+            using mp = sycl::multi_ptr<dtype, sycl::access::address_space::global_space>;
+            using mp_acc = sycl::multi_ptr<acc_type, sycl::access::address_space::global_space>;
+            xmx::joint_matrix<sycl::sub_group, dtype, xmx::use::a, TM, TK, xmx::layout::row_major> tile_a;
+            xmx::joint_matrix<sycl::sub_group, dtype, xmx::use::b, TK, TN, b_layout> tile_b;
+            xmx::joint_matrix<sycl::sub_group, acc_type, xmx::use::accumulator, TM, TN> tile_c;
+
+            xmx::joint_matrix_fill(sg, tile_c, 0);
+            for (size_t kk = 0; kk < k; kk += TK)
+            {
+                auto pA = mp(mat_ptr(a, lda, g_i * TM, kk));
+                auto pB = mp(mat_ptr(b, ldb,
+                                     b_layout == xmx::layout::row_major ? kk : g_j * TN,
+                                     b_layout == xmx::layout::row_major ? g_j * TN : kk));
+
+                joint_matrix_load(sg, tile_a, pA, lda);
+                joint_matrix_load(sg, tile_b, pB, ldb);
+                joint_matrix_mad(sg, tile_c, tile_a, tile_b, tile_c);
+            }
+
+            auto pC = mp_acc(mat_ptr(c, ldc, g_i * TM, g_j * TN));
+            joint_matrix_store(sg, tile_c, pC, ldc, xmx::layout::row_major);
+        }));
+}
@@ -0,0 +1,456 @@
+#pragma once
+
+#include <algorithm>
+#include <tuple>
+#include <sycl/sycl.hpp>
+#include <oneapi/mkl.hpp>
+
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// A : [m,k] in row-major
+// B : [k,n] in row-major or col-major
+// C = A x B : [m,n] in row-major
+
+// Host reference on all cores: blocks of rows of C. Row-major B is accumulated row by row of B so the inner loop
+// is a contiguous axpy, col-major B gives contiguous dot products. Unlike cbu::matrix_multiply_ref it must not be
+// called from inside a host_parallel_for task (the batched reference keeps the serial one per problem).
+template<typename T, cbu::matrix_layout b_layout>
+void matrix_multiply_host_ref(const T *a, const T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::host_parallel_for(m, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            T *c_row = c + i * ldc;
+            if constexpr (b_layout == matrix_layout::row_major) {
+                std::fill(c_row, c_row + n, T{0});
+                for (size_t p = 0; p < k; p++) {
+                    T a_ip = mat(a, lda, i, p);
+                    const T *b_row = b + p * ldb;
+                    for (size_t j = 0; j < n; j++) {
+                        c_row[j] += a_ip * b_row[j];
+                    }
+                }
+            } else {
+                for (size_t j = 0; j < n; j++) {
+                    c_row[j] = bench::host_simd_sum<T>(0, k, [&](size_t p) {
+                        return mat(a, lda, i, p) * mat(b, ldb, j, p);
+                    });
+                }
+            }
+        }
+    }, 1);
+}
+
+template<typename T, cbu::matrix_layout b_layout>
+void matrix_multiply_mkl(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    // A and C stay row-major either way; col-major B [k,n] is row-major B^T [n,k], passed as transposed.
+    constexpr bool b_row = b_layout == matrix_layout::row_major;
+    try {
+        bench::track(oneapi::mkl::blas::row_major::gemm(
+            q,
+            oneapi::mkl::transpose::nontrans,
+            b_row ? oneapi::mkl::transpose::nontrans : oneapi::mkl::transpose::trans,
+            m, n, k,
+            static_cast<T>(1),
+            a, k,
+            b, b_row ? n : k,
+            static_cast<T>(0),
+            c, n));
+    } catch (const std::exception &e) {
+        // rethrow or handle as desired; here we convert to runtime_error with message.
+        std::cout << std::string("oneMKL gemm failed: ") + e.what() + "\n";
+        exit(1);
+    }
+}
+
+template<typename T, cbu::matrix_layout b_layout>
+void matrix_multiply_naive(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.parallel_for({m, n}, [=](sycl::id<2> idx) {
+        size_t i = idx[0];
+        size_t j = idx[1];
+        T sum = 0;
+        for (size_t p = 0; p < k; p++) {
+            if constexpr (b_layout == matrix_layout::row_major) {
+                sum += mat(a, lda, i, p) * mat(b, ldb, p, j);
+            } else {
+                sum += mat(a, lda, i, p) * mat(b, ldb, j, p);
+            }
+        }
+        mat(c, ldc, i, j) = sum;
+    }));
+}
+
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_nd_range(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t i = item.get_global_id(0);
+            size_t j = item.get_global_id(1);
+            if (i >= m || j >= n) return;
+
+            T sum = 0;
+            for (size_t p = 0; p < k; p++) {
+                if constexpr (b_layout == matrix_layout::row_major) {
+                    sum += mat(a, lda, i, p) * mat(b, ldb, p, j);
+                } else {
+                    sum += mat(a, lda, i, p) * mat(b, ldb, j, p);
+                }
+            }
+            mat(c, ldc, i, j) = sum;
+        }));
+}
+
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_nd_range_vec(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t i = item.get_global_id(0);
+            size_t j = item.get_global_id(1);
+            if (i >= m || j >= n) return;
+
+            sycl::vec<T, WI_SIZE> vec_a, vec_b, vec_c{0};
+
+            size_t p = 0;
+            for (; p + WI_SIZE <= k; p += WI_SIZE) {
+                vec_a.load(0, mat_ptr(a, lda, i, p));
+                if constexpr (b_layout == matrix_layout::row_major) {
+                    for (int v = 0; v < WI_SIZE; ++v) {
+                        vec_b[v] = mat(b, ldb, p + v, j);
+                    }
+                } else {
+                    vec_b.load(0, mat_ptr(b, ldb, j, p));
+                }
+                vec_c += vec_a * vec_b;
+            }
+
+            T sum = 0;
+            for (int v = 0; v < WI_SIZE; ++v) {
+                sum += vec_c[v];
+            }
+            // k tail
+            for (; p < k; p++) {
+                if constexpr (b_layout == matrix_layout::row_major) {
+                    sum += mat(a, lda, i, p) * mat(b, ldb, p, j);
+                } else {
+                    sum += mat(a, lda, i, p) * mat(b, ldb, j, p);
+                }
+            }
+            mat(c, ldc, i, j) = sum;
+        }));
+}
+
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_nd_range_slm(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.submit([&](sycl::handler &cgh) {
+        sycl::local_accessor<T, 2> slm_a{{WG_SIZE, WG_SIZE}, cgh};
+        sycl::local_accessor<T, 2> slm_b{{WG_SIZE, WG_SIZE + 1}, cgh}; // avoid bank conflict for b in col_major.
+
+        cgh.parallel_for(
+            sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
+            [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t i = item.get_global_id(0);
+                size_t j = item.get_global_id(1);
+
+                size_t l_i = item.get_local_id(0);
+                size_t l_j = item.get_local_id(1);
+
+                // Out-of-range work-items still take part in the barriers and load zeros.
+                T sum = 0;
+                for (size_t p = 0; p < k; p += WG_SIZE) {
+                    slm_a[l_i][l_j] = i < m && p + l_j < k ? mat(a, lda, i, p + l_j) : T{0};
+                    if constexpr (b_layout == matrix_layout::row_major) {
+                        slm_b[l_i][l_j] = p + l_i < k && j < n ? mat(b, ldb, p + l_i, j) : T{0};
+                    } else {
+                        // Diagonal block mapping, equivalent to:
+                        // slm_b[l_i][l_j] = mat(b, ldb, j, p + l_i);
+                        size_t b_j = item.get_group(1) * WG_SIZE + l_i;
+                        slm_b[l_j][l_i] = b_j < n && p + l_j < k ? mat(b, ldb, b_j, p + l_j) : T{0};
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+
+                    for (size_t tile_k = 0; tile_k < WG_SIZE; tile_k++) {
+                        sum += slm_a[l_i][tile_k] * slm_b[tile_k][l_j];
+                    }
+                    item.barrier(sycl::access::fence_space::local_space);
+                }
+                if (i < m && j < n) {
+                    mat(c, ldc, i, j) = sum;
+                }
+            });
+    }));
+}
+
+// Ping-pong version of matrix_multiply_nd_range_slm: the next K tile is prefetched into the second
+// SLM buffer while the current one is consumed, so only one barrier per K step is needed.
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_nd_range_slm_double_buffer(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.submit([&](sycl::handler &cgh) {
+        sycl::local_accessor<T, 3> slm_a{{2, WG_SIZE, WG_SIZE}, cgh};
+        sycl::local_accessor<T, 3> slm_b{{2, WG_SIZE, WG_SIZE + 1}, cgh}; // avoid bank conflict for b in col_major.
+
+        cgh.parallel_for(
+            sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
+            [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t i = item.get_global_id(0);
+                size_t j = item.get_global_id(1);
+
+                size_t l_i = item.get_local_id(0);
+                size_t l_j = item.get_local_id(1);
+
+                auto load_tile = [&](size_t buf, size_t p) {
+                    slm_a[buf][l_i][l_j] = i < m && p + l_j < k ? mat(a, lda, i, p + l_j) : T{0};
+                    if constexpr (b_layout == matrix_layout::row_major) {
+                        slm_b[buf][l_i][l_j] = p + l_i < k && j < n ? mat(b, ldb, p + l_i, j) : T{0};
+                    } else {
+                        // Diagonal block mapping, same as matrix_multiply_nd_range_slm.
+                        size_t b_j = item.get_group(1) * WG_SIZE + l_i;
+                        slm_b[buf][l_j][l_i] = b_j < n && p + l_j < k ? mat(b, ldb, b_j, p + l_j) : T{0};
+                    }
+                };
+
+                load_tile(0, 0);
+                item.barrier(sycl::access::fence_space::local_space);
+
+                T sum = 0;
+                size_t buf = 0;
+                for (size_t p = 0; p < k; p += WG_SIZE) {
+                    // The other buffer was released by the barrier at the end of the previous step.
+                    if (p + WG_SIZE < k) {
+                        load_tile(buf ^ 1, p + WG_SIZE);
+                    }
+
+                    for (size_t tile_k = 0; tile_k < WG_SIZE; tile_k++) {
+                        sum += slm_a[buf][l_i][tile_k] * slm_b[buf][tile_k][l_j];
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+                    buf ^= 1;
+                }
+                if (i < m && j < n) {
+                    mat(c, ldc, i, j) = sum;
+                }
+            });
+    }));
+}
+
+template<typename T, size_t WG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_subgroup_broadcast(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.submit([&](sycl::handler &h) {
+        h.parallel_for(
+            sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
+            [=](sycl::nd_item<2> it) [[sycl::reqd_sub_group_size(WG_SIZE)]] {
+                size_t i = it.get_global_id(0);
+                size_t j = it.get_global_id(1);
+                size_t local_j = it.get_local_id(1);
+
+                // A sub-group is one row of the work-group: i is uniform, all lanes stay
+                // active for the broadcast and only lanes with j >= n skip the B reads.
+                if (i >= m) return;
+
+                T sum = 0;
+                for (size_t t = 0; t < k; t += WG_SIZE) {
+                    size_t tile = std::min(WG_SIZE, k - t);
+                    T a_i_tile_j = local_j < tile ? mat(a, lda, i, t + local_j) : T{0};
+                    for (size_t tile_k = 0; tile_k < tile; tile_k++) {
+                        T a_i_tile_k = group_broadcast(it.get_sub_group(), a_i_tile_j, tile_k);
+                        if (j >= n) continue;
+                        if constexpr (b_layout == matrix_layout::row_major) {
+                            sum += a_i_tile_k * mat(b, ldb, t + tile_k, j);
+                        } else {
+                            sum += a_i_tile_k * mat(b, ldb, j, t + tile_k);
+                        }
+                    }
+                }
+
+                if (j < n) {
+                    mat(c, ldc, i, j) = sum;
+                }
+            });
+    }));
+}
+
+// Register blocking: a work-group computes a BM x BN block of C from BM x BK / BK x BN tiles staged in SLM,
+// each work-item accumulates a TM x TN micro-tile in registers, so every SLM load feeds TM (or TN) FMAs.
+// Work-item (l_i, l_j) owns rows l_i + tm * WG_M and cols l_j + tn * WG_N of the block,
+// which keeps SLM reads of neighbouring lanes contiguous and C stores coalesced.
+template<typename T, size_t BM, size_t BN, size_t BK, size_t TM, size_t TN, size_t SG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_nd_range_slm_reg_tile(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k) {
+    using namespace cbu;
+    constexpr size_t WG_M = BM / TM, WG_N = BN / TN, WG_ITEMS = WG_M * WG_N;
+    static_assert(BM % TM == 0 && BN % TN == 0, "Block must be divisible by micro-tile");
+    static_assert(BM * BK % WG_ITEMS == 0 && BK * BN % WG_ITEMS == 0, "Tiles must be evenly loaded by the work-group");
+
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.submit([&](sycl::handler &cgh) {
+        sycl::local_accessor<T, 2> slm_a{{BK, BM + 1}, cgh}; // A tile transposed, avoid bank conflict on store.
+        sycl::local_accessor<T, 2> slm_b{{BK, BN}, cgh};
+
+        cgh.parallel_for(
+            sycl::nd_range<2>{{ceil_div(m, BM) * WG_M, ceil_div(n, BN) * WG_N}, {WG_M, WG_N}},
+            [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t l_i = item.get_local_id(0);
+                size_t l_j = item.get_local_id(1);
+                size_t l_id = item.get_local_linear_id();
+                size_t block_i = item.get_group(0) * BM;
+                size_t block_j = item.get_group(1) * BN;
+
+                T acc[TM][TN] = {};
+                T reg_a[TM], reg_b[TN];
+
+                // Edge blocks are zero-padded in SLM, interior blocks (uniform per work-group) skip the checks.
+                bool interior_mn = block_i + BM <= m && block_j + BN <= n;
+                for (size_t p = 0; p < k; p += BK) {
+                    bool interior = interior_mn && p + BK <= k;
+                    // A is row-major, read along k.
+                    for (size_t l = 0; l < BM * BK / WG_ITEMS; l++) {
+                        size_t e = l * WG_ITEMS + l_id;
+                        size_t r = e / BK, t = e % BK;
+                        bool in = interior || (block_i + r < m && p + t < k);
+                        slm_a[t][r] = in ? mat(a, lda, block_i + r, p + t) : T{0};
+                    }
+                    for (size_t l = 0; l < BK * BN / WG_ITEMS; l++) {
+                        size_t e = l * WG_ITEMS + l_id;
+                        if constexpr (b_layout == matrix_layout::row_major) {
+                            // read along n
+                            size_t t = e / BN, col = e % BN;
+                            bool in = interior || (p + t < k && block_j + col < n);
+                            slm_b[t][col] = in ? mat(b, ldb, p + t, block_j + col) : T{0};
+                        } else {
+                            // read along k
+                            size_t col = e / BK, t = e % BK;
+                            bool in = interior || (block_j + col < n && p + t < k);
+                            slm_b[t][col] = in ? mat(b, ldb, block_j + col, p + t) : T{0};
+                        }
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+
+                    for (size_t t = 0; t < BK; t++) {
+                        for (size_t tm = 0; tm < TM; tm++) {
+                            reg_a[tm] = slm_a[t][l_i + tm * WG_M];
+                        }
+                        for (size_t tn = 0; tn < TN; tn++) {
+                            reg_b[tn] = slm_b[t][l_j + tn * WG_N];
+                        }
+                        for (size_t tm = 0; tm < TM; tm++) {
+                            for (size_t tn = 0; tn < TN; tn++) {
+                                acc[tm][tn] += reg_a[tm] * reg_b[tn];
+                            }
+                        }
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+                }
+
+                for (size_t tm = 0; tm < TM; tm++) {
+                    for (size_t tn = 0; tn < TN; tn++) {
+                        size_t c_i = block_i + l_i + tm * WG_M, c_j = block_j + l_j + tn * WG_N;
+                        if (interior_mn || (c_i < m && c_j < n)) {
+                            mat(c, ldc, c_i, c_j) = acc[tm][tn];
+                        }
+                    }
+                }
+            });
+    }));
+}
+
+// Batched GEMM: `batch` independent problems of the same shape in one launch. The batch index is the
+// slowest nd_range dimension and every work-group computes one tile of one problem, same as
+// matrix_multiply_nd_range_slm. operands(p) returns the (a, b, c) pointers of problem p.
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, cbu::matrix_layout b_layout, typename Operands>
+void matrix_multiply_batch_slm(sycl::queue &q, Operands operands, size_t m, size_t n, size_t k, size_t batch) {
+    using namespace cbu;
+    size_t lda = k, ldb = b_layout == matrix_layout::row_major ? n : k, ldc = n;
+    bench::track(q.submit([&](sycl::handler &cgh) {
+        sycl::local_accessor<T, 2> slm_a{{WG_SIZE, WG_SIZE}, cgh};
+        sycl::local_accessor<T, 2> slm_b{{WG_SIZE, WG_SIZE + 1}, cgh}; // avoid bank conflict for b in col_major.
+
+        cgh.parallel_for(
+            sycl::nd_range<3>{{batch, round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {1, WG_SIZE, WG_SIZE}},
+            [=](sycl::nd_item<3> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                auto [a, b, c] = operands(item.get_global_id(0));
+                size_t i = item.get_global_id(1);
+                size_t j = item.get_global_id(2);
+
+                size_t l_i = item.get_local_id(1);
+                size_t l_j = item.get_local_id(2);
+
+                T sum = 0;
+                for (size_t p = 0; p < k; p += WG_SIZE) {
+                    slm_a[l_i][l_j] = i < m && p + l_j < k ? mat(a, lda, i, p + l_j) : T{0};
+                    if constexpr (b_layout == matrix_layout::row_major) {
+                        slm_b[l_i][l_j] = p + l_i < k && j < n ? mat(b, ldb, p + l_i, j) : T{0};
+                    } else {
+                        // Diagonal block mapping, same as matrix_multiply_nd_range_slm.
+                        size_t b_j = item.get_group(2) * WG_SIZE + l_i;
+                        slm_b[l_j][l_i] = b_j < n && p + l_j < k ? mat(b, ldb, b_j, p + l_j) : T{0};
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+
+                    for (size_t tile_k = 0; tile_k < WG_SIZE; tile_k++) {
+                        sum += slm_a[l_i][tile_k] * slm_b[tile_k][l_j];
+                    }
+                    item.barrier(sycl::access::fence_space::local_space);
+                }
+                if (i < m && j < n) {
+                    mat(c, ldc, i, j) = sum;
+                }
+            });
+    }));
+}
+
+// Strided batch: problem p reads a + p * stride_a, b + p * stride_b and writes c + p * stride_c.
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_batch_strided_slm(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k,
+                                       size_t batch, size_t stride_a, size_t stride_b, size_t stride_c) {
+    matrix_multiply_batch_slm<T, WG_SIZE, SG_SIZE, b_layout>(q, [=](size_t p) {
+        return std::make_tuple(a + p * stride_a, b + p * stride_b, c + p * stride_c);
+    }, m, n, k, batch);
+}
+
+// Pointer-array batch: a[p], b[p] and c[p] are the operands of problem p, the arrays must be device readable.
+template<typename T, size_t WG_SIZE, size_t SG_SIZE, cbu::matrix_layout b_layout>
+void matrix_multiply_batch_ptr_slm(sycl::queue &q, T **a, T **b, T **c, size_t m, size_t n, size_t k, size_t batch) {
+    matrix_multiply_batch_slm<T, WG_SIZE, SG_SIZE, b_layout>(q, [=](size_t p) {
+        return std::make_tuple(a[p], b[p], c[p]);
+    }, m, n, k, batch);
+}
+
+// B in col_major is passed to oneMKL as a transposed row-major matrix, C stays row-major.
+template<typename T, cbu::matrix_layout b_layout>
+void matrix_multiply_batch_strided_mkl(sycl::queue &q, T *a, T *b, T *c, size_t m, size_t n, size_t k,
+                                       size_t batch, size_t stride_a, size_t stride_b, size_t stride_c) {
+    using namespace cbu;
+    constexpr bool b_row = b_layout == matrix_layout::row_major;
+    bench::track(oneapi::mkl::blas::row_major::gemm_batch(
+        q,
+        oneapi::mkl::transpose::nontrans,
+        b_row ? oneapi::mkl::transpose::nontrans : oneapi::mkl::transpose::trans,
+        m, n, k,
+        static_cast<T>(1),
+        a, k, stride_a,
+        b, b_row ? n : k, stride_b,
+        static_cast<T>(0),
+        c, n, stride_c,
+        batch));
+}
@@ -1,115 +1,153 @@
 #include <sycl/sycl.hpp>
 
+#include "common/bench-driver.hpp"
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
 #include "cpp-bench-utils/utils.hpp"
 
 // In  : [m,n] in row-major
 // Out : [n,m] in row-major
 
+// Host reference on all cores: blocks of rows of out, walked in 32-wide column tiles of in so the strided reads of
+// a tile stay in cache while out is written contiguously.
+template<typename T>
+void matrix_transpose_host_ref(const T *in, T *out, size_t m, size_t n) {
+    using namespace cbu;
+    constexpr size_t tile = 32;
+    size_t ld_in = n, ld_out = m;
+    bench::host_parallel_for(n, [&](size_t begin, size_t end) {
+        for (size_t i0 = 0; i0 < m; i0 += tile) {
+            size_t i1 = std::min(i0 + tile, m);
+            for (size_t j = begin; j < end; j++) {
+                for (size_t i = i0; i < i1; i++) {
+                    mat(out, ld_out, j, i) = mat(in, ld_in, i, j);
+                }
+            }
+        }
+    }, tile);
+}
 
 template<typename T>
 void matrix_transpose_naive_read_continue(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     size_t ld_in = n, ld_out = m;
-    q.parallel_for({m, n}, [=](sycl::id<2> idx) {
+    bench::track(q.parallel_for({m, n}, [=](sycl::id<2> idx) {
         size_t i = idx[0];
         size_t j = idx[1];
         cbu::mat(out, ld_out, j, i) = cbu::mat(in, ld_in, i, j);
-    });
+    }));
 }
 
 template<typename T>
 void matrix_transpose_naive_write_continue(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     size_t ld_in = n, ld_out = m;
-    q.parallel_for({n, m}, [=](sycl::id<2> idx) {
+    bench::track(q.parallel_for({n, m}, [=](sycl::id<2> idx) {
         size_t i = idx[0];
         size_t j = idx[1];
         cbu::mat(out, ld_out, i, j) = cbu::mat(in, ld_in, j, i);
-    });
+    }));
 }
 
 template<typename T, size_t WG_SIZE, size_t SG_SIZE>
 void matrix_transpose_nd_range_read_continue(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, WG_SIZE, "N must be divisible by WG_SIZE");
-
     size_t ld_in = n, ld_out = m;
-    q.parallel_for(
-        sycl::nd_range<2>{{m, n}, {WG_SIZE, WG_SIZE}},
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
         [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t i = item.get_global_id(0);
             size_t j = item.get_global_id(1);
+            if (i >= m || j >= n) return;
             mat(out, ld_out, j, i) = mat(in, ld_in, i, j);
-        });
+        }));
 }
 
 template<typename T, size_t WG_SIZE, size_t SG_SIZE>
 void matrix_transpose_nd_range_write_continue(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, WG_SIZE, "N must be divisible by WG_SIZE");
-
     size_t ld_in = n, ld_out = m;
-    q.parallel_for(
-        sycl::nd_range<2>{{n, m}, {WG_SIZE, WG_SIZE}},
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(n, WG_SIZE), round_up(m, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
         [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t i = item.get_global_id(0);
             size_t j = item.get_global_id(1);
+            if (i >= n || j >= m) return;
             mat(out, ld_out, i, j) = mat(in, ld_in, j, i);
-        });
+        }));
 }
 
 template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
 void matrix_transpose_nd_range_read_continue_vec(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, WG_SIZE * WI_SIZE, "N must be divisible by WG_SIZE * WI_SIZE");
-
     size_t ld_in = n, ld_out = m;
-    q.parallel_for(
-        sycl::nd_range<2>{{m, n / WI_SIZE}, {WG_SIZE, WG_SIZE}},
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(ceil_div(n, WI_SIZE), WG_SIZE)}, {WG_SIZE, WG_SIZE}},
         [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t i = item.get_global_id(0);
             size_t j = item.get_global_id(1) * WI_SIZE;
-            sycl::vec<T, WI_SIZE> vec;
-            vec.load(0, mat_ptr(in, ld_in, i, j));
-            for (size_t k = 0; k < WI_SIZE; ++k) {
-                mat(out, ld_out, j + k, i) = vec[k];
+            if (i >= m || j >= n) return;
+            if (j + WI_SIZE <= n) {
+                sycl::vec<T, WI_SIZE> vec;
+                vec.load(0, mat_ptr(in, ld_in, i, j));
+                for (size_t k = 0; k < WI_SIZE; ++k) {
+                    mat(out, ld_out, j + k, i) = vec[k];
+                }
+            } else {
+                for (size_t k = j; k < n; ++k) {
+                    mat(out, ld_out, k, i) = mat(in, ld_in, i, k);
+                }
             }
-        });
+        }));
 }
 
 template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
 void matrix_transpose_nd_range_write_continue_vec(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, WG_SIZE * WI_SIZE, "N must be divisible by WG_SIZE * WI_SIZE");
-
     size_t ld_in = n, ld_out = m;
-    q.parallel_for(
-        sycl::nd_range<2>{{n, m / WI_SIZE}, {WG_SIZE, WG_SIZE}},
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(n, WG_SIZE), round_up(ceil_div(m, WI_SIZE), WG_SIZE)}, {WG_SIZE, WG_SIZE}},
         [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t i = item.get_global_id(0);
             size_t j = item.get_global_id(1) * WI_SIZE;
-            sycl::vec<T, WI_SIZE> vec;
-            for (size_t k = 0; k < WI_SIZE; ++k) {
-                vec[k] = mat(in, ld_in, j + k, i);
+            if (i >= n || j >= m) return;
+            if (j + WI_SIZE <= m) {
+                sycl::vec<T, WI_SIZE> vec;
+                for (size_t k = 0; k < WI_SIZE; ++k) {
+                    vec[k] = mat(in, ld_in, j + k, i);
+                }
+                vec.store(0, mat_ptr(out, ld_out, i, j));
+            } else {
+                for (size_t k = j; k < m; ++k) {
+                    mat(out, ld_out, i, k) = mat(in, ld_in, k, i);
+                }
             }
-            vec.store(0, mat_ptr(out, ld_out, i, j));
-        });
+        }));
 }
 
 template<typename T, size_t WG_SIZE, size_t SG_SIZE, size_t WI_SIZE>
 void matrix_transpose_nd_range_tile_vec(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     using namespace cbu;
-    check_divisible(m, WG_SIZE * WI_SIZE, "M must be divisible by WG_SIZE * WI_SIZE");
-    check_divisible(n, WG_SIZE * WI_SIZE, "N must be divisible by WG_SIZE * WI_SIZE");
-
     size_t ld_in = n, ld_out = m;
-    q.parallel_for(
-        sycl::nd_range<2>{{m / WI_SIZE, n / WI_SIZE}, {WG_SIZE, WG_SIZE}},
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{
+            {round_up(ceil_div(m, WI_SIZE), WG_SIZE), round_up(ceil_div(n, WI_SIZE), WG_SIZE)},
+            {WG_SIZE, WG_SIZE}
+        },
         [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
             size_t i = item.get_global_id(0) * WI_SIZE;
             size_t j = item.get_global_id(1) * WI_SIZE;
+            if (i >= m || j >= n) return;
+
+            if (i + WI_SIZE > m || j + WI_SIZE > n) {
+                // partial block on the right or bottom edge
+                for (size_t k_i = i; k_i < std::min(i + WI_SIZE, m); ++k_i) {
+                    for (size_t k_j = j; k_j < std::min(j + WI_SIZE, n); ++k_j) {
+                        mat(out, ld_out, k_j, k_i) = mat(in, ld_in, k_i, k_j);
+                    }
+                }
+                return;
+            }
 
             sycl::vec<T, WI_SIZE> vec[WI_SIZE];
             for (size_t k = 0; k < WI_SIZE; ++k) {
@@ -126,20 +164,17 @@ void matrix_transpose_nd_range_tile_vec(sycl::queue &q, T *in, T *out, size_t m,
             for (size_t k = 0; k < WI_SIZE; ++k) {
                 vec[k].store(0, mat_ptr(out, ld_out, j + k, i));
             }
-        });
+        }));
 }
 
 template<typename T, size_t WG_SIZE, size_t SG_SIZE>
 void matrix_transpose_nd_range_tile_slm(sycl::queue &q, T *in, T *out, size_t m, size_t n) {
     using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, WG_SIZE, "N must be divisible by WG_SIZE");
-
     size_t ld_in = n, ld_out = m;
-    q.submit([&](sycl::handler &h) {
+    bench::track(q.submit([&](sycl::handler &h) {
         sycl::local_accessor<T, 2> slm{{WG_SIZE, WG_SIZE + 1}, h}; // avoid bank conflict
         h.parallel_for(
-            sycl::nd_range<2>{{m, n}, {WG_SIZE, WG_SIZE}},
+            sycl::nd_range<2>{{round_up(m, WG_SIZE), round_up(n, WG_SIZE)}, {WG_SIZE, WG_SIZE}},
             [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
                 size_t i = item.get_global_id(0);
                 size_t j = item.get_global_id(1);
@@ -147,42 +182,45 @@ void matrix_transpose_nd_range_tile_slm(sycl::queue &q, T *in, T *out, size_t m,
                 size_t l_i = item.get_local_id(0);
                 size_t l_j = item.get_local_id(1);
 
-                slm[l_i][l_j] = mat(in, ld_in, i, j);
+                if (i < m && j < n) {
+                    slm[l_i][l_j] = mat(in, ld_in, i, j);
+                }
                 item.barrier(sycl::access::fence_space::local_space);
 
                 // Diagonal block mapping
                 i = item.get_group(1) * WG_SIZE + item.get_local_id(0);
                 j = item.get_group(0) * WG_SIZE + item.get_local_id(1);
-                mat(out, ld_out, i, j) = slm[l_j][l_i];
+                if (i < n && j < m) {
+                    mat(out, ld_out, i, j) = slm[l_j][l_i];
+                }
             });
-    });
+    }));
 }
 
 
-int main() {
+int main(int argc, char *argv[]) {
     using namespace cbu;
     using dtype = float;
     constexpr uint16_t wg_size = 32;
     constexpr uint8_t sg_size = 32;
     constexpr uint8_t wi_size = 4;
 
-    size_t secs = 10;
-    size_t loop = 100;
-    size_t m = 20 * 1024, n = 5 * 1024; // 100M elements
+    bench::Driver driver{argc, argv};
+    size_t m = driver.arg("m", 20 * 1024), n = driver.arg("n", 5 * 1024); // 100M elements
 
     size_t size = m * n;
     std::vector<dtype> matrix(size), out(size);
     random_fill(matrix);
 
-    std::cout << "matrix_transpose_ref:\n";
     BenchmarkOptions opt{
         .total_mem_bytes = 2 * m * n * sizeof(dtype),
     };
-    benchmark_func_by_time(secs, [&] { matrix_transpose_ref(matrix, out, m, n); }, opt);
+    driver.run_ref("matrix_transpose_ref", [&] { matrix_transpose_host_ref(matrix.data(), out.data(), m, n); }, opt);
 
-    sycl::queue q{gpu_selector_by_cu, sycl::property::queue::in_order()};
-    auto *d_src = sycl::malloc_device<dtype>(size, q);
-    auto *d_out = sycl::malloc_device<dtype>(size, q);
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_src = pool.malloc_device<dtype>(size, q);
+    auto *d_out = pool.malloc_device<dtype>(size, q);
     q.memcpy(d_src, matrix.data(), size * sizeof(dtype)).wait();
 
     using func_t = std::function<void(sycl::queue &, dtype *, dtype *, size_t, size_t)>;
@@ -221,16 +259,11 @@ int main() {
         },
     };
 
-    for (auto [func_name,func]: funcs) {
-        std::cout << "\n" << func_name << ":\n";
-        q.fill(d_out, dtype{0}, size).wait();
-        benchmark_func_by_time(secs, [&]() {
-            func(q, d_src, d_out, m, n);
-            q.wait();
-        }, opt);
-        sycl_acc_check(q, out, d_out);
-    }
-
-    sycl::free(d_src, q);
-    sycl::free(d_out, q);
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q, d_src, d_out, m, n); },
+                   [&] { q.fill(d_out, dtype{0}, size).wait(); },
+                   [&] { sycl_acc_check(q, out, d_out); });
+
+    pool.free(d_src, q);
+    pool.free(d_out, q);
 }
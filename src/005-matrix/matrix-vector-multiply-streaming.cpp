@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/profiling.hpp"
+#include "common/tensor-file.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-vector-multiply.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// GEMV with A in host memory, for matrices that do not fit in one device allocation.
+// Every variant starts from A on the host, so the numbers are end to end and bounded by the link.
+// --a=<file> streams A straight from an mmap of a tensor file (common/tensor-file.hpp) instead of
+// random data; the file decides m, n and the layout, the section of the other layout is skipped.
+
+template <cbu::matrix_layout a_layout>
+void test_matrix_vector_multiply_streaming(bench::Driver& driver)
+{
+    using namespace cbu;
+    std::string a_major = a_layout == matrix_layout::row_major ? "row major" : "col major";
+
+    using dtype = float;
+    constexpr size_t wg_size = 256;
+    constexpr size_t sg_size = 32;
+    constexpr size_t mb = 1024 * 1024;
+
+    std::optional<bench::MappedTensor> mapped;
+    std::string a_path = driver.option("a", "");
+    if (!a_path.empty())
+    {
+        mapped.emplace(a_path);
+        if (mapped->layout() != a_layout) return;
+        if (!mapped->packed())
+        {
+            throw std::runtime_error("matrix-vector-multiply-streaming needs a packed matrix: " + a_path);
+        }
+    }
+
+    size_t m = mapped ? mapped->rows() : driver.arg("m", 256 * 1024);
+    size_t n = mapped ? mapped->cols() : driver.arg("n", 1024); // 1 GB matrix by default
+    size_t tile_bytes = driver.arg("tile_size", 64 * mb);
+    size_t line_size = a_layout == matrix_layout::row_major ? n : m;
+    size_t tile_size = std::max(tile_bytes / sizeof(dtype), line_size);
+
+    sycl::queue& q = driver.queue();
+    size_t max_alloc = q.get_device().get_info<sycl::info::device::max_mem_alloc_size>();
+    bool a_fits = m * n * sizeof(dtype) <= max_alloc;
+    driver.section("streaming, matrix a in " + a_major + (a_fits ? "" : ", larger than max_mem_alloc_size"));
+
+    std::vector<dtype> random_a, b(n), c(m);
+    random_fill(b);
+    dtype* a = nullptr;
+    if (mapped)
+    {
+        // lazy page-in is timed on its own, the variants below then run on resident pages
+        auto start = std::chrono::steady_clock::now();
+        mapped->page_in();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        driver.log() << "page-in of " << a_path << ": " << ms << " ms, "
+                     << mapped->data_bytes() / (ms * 1e6) << " GB/s\n";
+        a = mapped->data<dtype>();
+    }
+    else
+    {
+        random_a.resize(m * n);
+        random_fill(random_a);
+        a = random_a.data();
+    }
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = (m * n + n + m) * sizeof(dtype),
+        .total_flop = 2 * m * n,
+    };
+    driver.run_ref("matrix_vector_multiply_ref", [&]()
+    {
+        matrix_vector_multiply_ref<dtype, a_layout>(a, b.data(), c.data(), m, n);
+    }, opt);
+
+    auto& pool = bench::usm_pool();
+    sycl::queue copy_q{q.get_context(), q.get_device(), bench::in_order_like(q)};
+    dtype* pinned_a = mapped ? mapped->stage_to_host<dtype>(q) : pool.malloc_host<dtype>(m * n, q);
+    if (!mapped)
+    {
+        std::copy(random_a.begin(), random_a.end(), pinned_a);
+    }
+    auto* d_b = pool.malloc_device<dtype>(b.size(), q);
+    auto* d_c = pool.malloc_device<dtype>(c.size(), q);
+    q.memcpy(d_b, b.data(), b.size() * sizeof(dtype)).wait();
+    std::vector<dtype*> tiles{pool.malloc_device<dtype>(tile_size, q), pool.malloc_device<dtype>(tile_size, q)};
+    std::vector<dtype*> single_tile{tiles[0]};
+
+    using func_t = std::function<void(sycl::queue&)>;
+    std::vector<std::tuple<std::string, func_t>> funcs;
+
+    // Baseline when A fits: copy all of A, then one GEMV.
+    dtype* d_a = a_fits ? pool.malloc_device<dtype>(m * n, q) : nullptr;
+    if (d_a)
+    {
+        funcs.emplace_back("matrix_vector_multiply_copy_then_compute", [&](sycl::queue& q)
+        {
+            bench::track(q.memcpy(d_a, pinned_a, m * n * sizeof(dtype)));
+            matrix_vector_multiply_row_split_wg<dtype, a_layout, wg_size, sg_size>(q, d_a, d_b, d_c, m, n);
+        });
+    }
+    funcs.emplace_back("matrix_vector_multiply_streaming_single_buffer", [&](sycl::queue& q)
+    {
+        matrix_vector_multiply_streaming<dtype, a_layout, wg_size, sg_size>(
+            q, copy_q, pinned_a, d_b, d_c, m, n, single_tile, tile_size);
+    });
+    funcs.emplace_back("matrix_vector_multiply_streaming", [&](sycl::queue& q)
+    {
+        matrix_vector_multiply_streaming<dtype, a_layout, wg_size, sg_size>(
+            q, copy_q, pinned_a, d_b, d_c, m, n, tiles, tile_size);
+    });
+    funcs.emplace_back("matrix_vector_multiply_streaming_pageable", [&](sycl::queue& q)
+    {
+        matrix_vector_multiply_streaming<dtype, a_layout, wg_size, sg_size>(
+            q, copy_q, a, d_b, d_c, m, n, tiles, tile_size);
+    });
+
+    driver.baseline(std::get<0>(funcs.front()));
+    driver.run_all(funcs, opt,
+                   [&](func_t& func) { func(q); },
+                   [&] { q.fill(d_c, dtype{0}, c.size()).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    pool.free(d_a, q);
+    pool.free(tiles[0], q);
+    pool.free(tiles[1], q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
+    pool.free(pinned_a, q);
+}
+
+
+int main(int argc, char* argv[])
+{
+    bench::Driver driver{argc, argv};
+    test_matrix_vector_multiply_streaming<cbu::matrix_layout::row_major>(driver);
+    test_matrix_vector_multiply_streaming<cbu::matrix_layout::col_major>(driver);
+}
@@ -1,251 +1,41 @@
 #include <sycl/sycl.hpp>
 
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-vector-multiply.hpp"
 #include "cpp-bench-utils/utils.hpp"
 
-// A matrix: [m, n] in row-major or col-major
-// b vector: [n]
-// o = A x b^T vector : [m]
-
-template <typename T, cbu::matrix_layout a_layout>
-void matrix_vector_multiply_ref(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c, size_t m, size_t n)
-{
-    using namespace cbu;
-    size_t ld = a_layout == matrix_layout::row_major ? n : m;
-    for (size_t i = 0; i < m; i++)
-    {
-        T sum = 0;
-        for (size_t k = 0; k < n; k++)
-        {
-            if constexpr (a_layout == matrix_layout::row_major)
-            {
-                sum += mat(a.data(), ld, i, k) * b[k];
-            }
-            else
-            {
-                sum += mat(a.data(), ld, k, i) * b[k];
-            }
-        }
-        c[i] = sum;
-    }
-}
-
-template <typename T, cbu::matrix_layout a_layout>
-void matrix_vector_multiply_naive(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
-{
-    using namespace cbu;
-    size_t ld = a_layout == matrix_layout::row_major ? n : m;
-    q.parallel_for(
-        sycl::range<1>(m),
-        [=](sycl::id<1> i)
-        {
-            T sum = 0;
-            for (size_t k = 0; k < n; k++)
-            {
-                if constexpr (a_layout == matrix_layout::row_major)
-                {
-                    sum += mat(a, ld, i, k) * b[k];
-                }
-                else
-                {
-                    sum += mat(a, ld, k, i) * b[k];
-                }
-            }
-            c[i] = sum;
-        });
-}
-
-template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
-void matrix_vector_multiply_nd_range(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
-{
-    using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-
-    size_t ld = a_layout == matrix_layout::row_major ? n : m;
-    q.parallel_for(
-        sycl::nd_range<1>{m, WG_SIZE},
-        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
-        {
-            T sum = 0;
-            size_t i = item.get_global_id();
-            for (size_t k = 0; k < n; k++)
-            {
-                if constexpr (a_layout == matrix_layout::row_major)
-                {
-                    sum += mat(a, ld, i, k) * b[k];
-                }
-                else
-                {
-                    sum += mat(a, ld, k, i) * b[k];
-                }
-            }
-            c[i] = sum;
-        });
-}
-
-template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
-void matrix_vector_multiply_row_split_sg(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
-{
-    using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, SG_SIZE, "N must be divisible by SG_SIZE");
-
-    size_t ld = a_layout == matrix_layout::row_major ? n : m;
-    q.parallel_for(
-        sycl::nd_range<2>{{m, SG_SIZE}, {WG_SIZE, SG_SIZE}},
-        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
-        {
-            size_t i = item.get_global_id(0);
-
-            auto sg = item.get_sub_group();
-            size_t sg_i = sg.get_local_linear_id();
-
-            T sum = 0;
-            for (size_t k = 0; k < n; k += SG_SIZE)
-            {
-                if constexpr (a_layout == matrix_layout::row_major)
-                {
-                    sum += mat(a, ld, i, k + sg_i) * b[k + sg_i];
-                }
-                else
-                {
-                    sum += mat(a, ld, k + sg_i, i) * b[k + sg_i];
-                }
-            }
-
-            T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
-
-            if (sg.leader())
-            {
-                c[i] = sg_sum;
-            }
-        });
-}
-
-template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
-void matrix_vector_multiply_row_split_slm(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
-{
-    using namespace cbu;
-    check_divisible(m, WG_SIZE, "M must be divisible by WG_SIZE");
-    check_divisible(n, SG_SIZE, "N must be divisible by SG_SIZE");
-    static_assert(WG_SIZE == SG_SIZE, "WG_SIZE must be equal to SG_SIZE");
-
-    size_t ld = a_layout == matrix_layout::row_major ? n : m;
-    q.submit([&](sycl::handler& h)
-    {
-        sycl::local_accessor<T, 2> slm{{WG_SIZE, WG_SIZE + 1}, h}; // avoid bank conflict
-        h.parallel_for(
-            sycl::nd_range<2>{{m, SG_SIZE}, {WG_SIZE, SG_SIZE}},
-            [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
-            {
-                size_t g_i = item.get_group(0);
-                size_t l_i = item.get_local_id(0);
-                size_t l_j = item.get_local_id(1);
-
-                T sum = 0;
-                for (size_t k = 0; k < n; k += SG_SIZE)
-                {
-                    if constexpr (a_layout == matrix_layout::row_major)
-                    {
-                        slm[l_i][l_j] = mat(a, ld, g_i * WG_SIZE + l_i, k + l_j);
-                    }
-                    else
-                    {
-                        // transpose a tile in slm
-                        // slm[l_i][l_j] = mat(a, ld, k + l_j, g_i * WG_SIZE + l_i);
-                        slm[l_j][l_i] = mat(a, ld, k + l_i, g_i * WG_SIZE + l_j);
-                    }
-
-                    item.barrier(sycl::access::fence_space::local_space);
-                    sum += slm[l_i][l_j] * b[k + l_j];
-                    item.barrier(sycl::access::fence_space::local_space);
-                }
-
-                auto sg = item.get_sub_group();
-                T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
-
-                if (sg.leader())
-                {
-                    c[g_i * WG_SIZE + l_i] = sg_sum;
-                }
-            });
-    });
-}
-
-template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
-void matrix_vector_multiply_row_split_wg(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
-{
-    using namespace cbu;
-    check_divisible(n, WG_SIZE, "N must be divisible by WG_SIZE");
-
-    size_t ld = a_layout == matrix_layout::row_major ? n : m;
-    size_t ele_per_sg = n / (WG_SIZE / SG_SIZE);
-    q.parallel_for(
-        sycl::nd_range<2>{{m, WG_SIZE}, {1, WG_SIZE}},
-        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
-        {
-            size_t i = item.get_global_id(0);
-
-            auto sg = item.get_sub_group();
-            size_t sg_i = sg.get_local_linear_id();
-            size_t sg_group_id = sg.get_group_id();
-            size_t start_id = sg_group_id * ele_per_sg;
-            size_t end_id = start_id + ele_per_sg;
-
-            T sum = 0;
-            for (size_t k = start_id; k < end_id; k += SG_SIZE)
-            {
-                if constexpr (a_layout == matrix_layout::row_major)
-                {
-                    sum += mat(a, ld, i, k + sg_i) * b[k + sg_i];
-                }
-                else
-                {
-                    sum += mat(a, ld, k + sg_i, i) * b[k + sg_i];
-                }
-            }
-
-            T sg_sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<>());
-
-            if (item.get_group().leader())
-            {
-                c[i] = sg_sum;
-            }
-        });
-}
-
-
 template <cbu::matrix_layout a_layout>
-void test_matrix_multiply()
+void test_matrix_multiply(bench::Driver& driver)
 {
     using namespace cbu;
     std::string a_major = a_layout == matrix_layout::row_major ? "row major" : "col major";
-    std::cout << "-------------- matrix a in " << a_major << " --------------\n";
+    driver.section("matrix a in " + a_major);
 
     using dtype = float;
     constexpr uint8_t sg_size = 32;
 
-    size_t secs = 10;
-    size_t m = 512 * 1024, n = 1024; // 1G FLOPs
+    size_t m = driver.arg("m", 512 * 1024), n = driver.arg("n", 1024); // 1G FLOPs
 
     std::vector<dtype> a(m * n), b(n), c(m);
-    random_fill(a);
-    random_fill(b);
-
-    sycl::queue q{gpu_selector_by_cu, sycl::property::queue::in_order()};
-    auto* d_a = sycl::malloc_device<dtype>(a.size(), q);
-    auto* d_b = sycl::malloc_device<dtype>(b.size(), q);
-    auto* d_c = sycl::malloc_device<dtype>(c.size(), q);
+    driver.input("a", a, m, n, a_layout);
+    driver.input("b", b, n, 1);
+
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    auto* d_a = pool.malloc_device<dtype>(a.size(), q);
+    auto* d_b = pool.malloc_device<dtype>(b.size(), q);
+    auto* d_c = pool.malloc_device<dtype>(c.size(), q);
     q.memcpy(d_a, a.data(), a.size() * sizeof(dtype)).wait();
     q.memcpy(d_b, b.data(), b.size() * sizeof(dtype)).wait();
 
-    std::cout << "matrix_vector_multiply_ref:\n";
     BenchmarkOptions opt{
         .total_mem_bytes = (m * n + n + m) * sizeof(dtype),
         .total_flop = 2 * m * n,
     };
-    benchmark_func_by_time(secs, [&]()
+    driver.run_ref("matrix_vector_multiply_ref", [&]()
     {
-        matrix_vector_multiply_ref<dtype, a_layout>(a, b, c, m, n);
+        matrix_vector_multiply_ref<dtype, a_layout>(a.data(), b.data(), c.data(), m, n);
     }, opt);
 
     using func_t = std::function<void(sycl::queue&, dtype*, dtype*, dtype*, size_t, size_t)>;
@@ -254,25 +44,27 @@ void test_matrix_multiply()
         {"matrix_vector_multiply_nd_range", matrix_vector_multiply_nd_range<dtype, a_layout, 256, sg_size>},
         {"matrix_vector_multiply_row_split_sg", matrix_vector_multiply_row_split_sg<dtype, a_layout, 32, sg_size>},
         {"matrix_vector_multiply_row_split_slm", matrix_vector_multiply_row_split_slm<dtype, a_layout, 32, sg_size>},
+        {
+            "matrix_vector_multiply_row_split_slm_double_buffer",
+            matrix_vector_multiply_row_split_slm_double_buffer<dtype, a_layout, 32, sg_size>
+        },
         {"matrix_vector_multiply_row_split_wg", matrix_vector_multiply_row_split_wg<dtype, a_layout, 256, sg_size>},
     };
 
-    for (auto [func_name,func] : funcs)
-    {
-        std::cout << "\n" << func_name << ":\n";
-        q.fill(d_c, dtype{0}, c.size()).wait();
-        benchmark_func_by_time(secs, [&]()
-        {
-            func(q, d_a, d_b, d_c, m, n);
-            q.wait();
-        }, opt);
-        sycl_acc_check(q, c, d_c);
-    }
+    driver.run_all(funcs, opt,
+                   [&](func_t& func) { func(q, d_a, d_b, d_c, m, n); },
+                   [&] { q.fill(d_c, dtype{0}, c.size()).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
 }
 
 
-int main()
+int main(int argc, char* argv[])
 {
-    test_matrix_multiply<cbu::matrix_layout::row_major>();
-    test_matrix_multiply<cbu::matrix_layout::col_major>();
+    bench::Driver driver{argc, argv};
+    test_matrix_multiply<cbu::matrix_layout::row_major>(driver);
+    test_matrix_multiply<cbu::matrix_layout::col_major>(driver);
 }
@@ -0,0 +1,445 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// A matrix: [m, n] in row-major or col-major
+// b vector: [n]
+// o = A x b^T vector : [m]
+
+template <typename T, cbu::matrix_layout a_layout>
+void matrix_vector_multiply_ref(const T* a, const T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    // Blocks of rows on all host threads; col-major walks a block column by column so the inner loop stays contiguous.
+    bench::host_parallel_for(m, [&](size_t begin, size_t end)
+    {
+        if constexpr (a_layout == matrix_layout::row_major)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                c[i] = bench::host_simd_sum<T>(0, n, [&](size_t k) { return mat(a, ld, i, k) * b[k]; });
+            }
+        }
+        else
+        {
+            std::fill(c + begin, c + end, T{0});
+            for (size_t k = 0; k < n; k++)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    c[i] += mat(a, ld, k, i) * b[k];
+                }
+            }
+        }
+    }, 64);
+}
+
+template <typename T, cbu::matrix_layout a_layout>
+void matrix_vector_multiply_naive(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    bench::track(q.parallel_for(
+        sycl::range<1>(m),
+        [=](sycl::id<1> i)
+        {
+            T sum = 0;
+            for (size_t k = 0; k < n; k++)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k) * b[k];
+                }
+                else
+                {
+                    sum += mat(a, ld, k, i) * b[k];
+                }
+            }
+            c[i] = sum;
+        }));
+}
+
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_nd_range(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(m, WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            T sum = 0;
+            size_t i = item.get_global_id();
+            if (i >= m) return;
+            for (size_t k = 0; k < n; k++)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k) * b[k];
+                }
+                else
+                {
+                    sum += mat(a, ld, k, i) * b[k];
+                }
+            }
+            c[i] = sum;
+        }));
+}
+
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_row_split_sg(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), SG_SIZE}, {WG_SIZE, SG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+
+            // The fastest dim of the work-group is exactly SG_SIZE wide, so each sub-group is one row and i is
+            // uniform within it: padding rows leave as whole sub-groups and the sub-group reduce below always
+            // sees all of its lanes. The other sub-group-per-row kernels rely on the same layout.
+            if (i >= m) return;
+
+            auto sg = item.get_sub_group();
+            size_t sg_i = sg.get_local_linear_id();
+
+            T sum = 0;
+            size_t k = 0;
+            for (; k + SG_SIZE <= n; k += SG_SIZE)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k + sg_i) * b[k + sg_i];
+                }
+                else
+                {
+                    sum += mat(a, ld, k + sg_i, i) * b[k + sg_i];
+                }
+            }
+            if (k + sg_i < n)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k + sg_i) * b[k + sg_i];
+                }
+                else
+                {
+                    sum += mat(a, ld, k + sg_i, i) * b[k + sg_i];
+                }
+            }
+
+            T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
+
+            if (sg.leader())
+            {
+                c[i] = sg_sum;
+            }
+        }));
+}
+
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_row_split_slm(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    static_assert(WG_SIZE == SG_SIZE, "WG_SIZE must be equal to SG_SIZE");
+
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    bench::track(q.submit([&](sycl::handler& h)
+    {
+        sycl::local_accessor<T, 2> slm{{WG_SIZE, WG_SIZE + 1}, h}; // avoid bank conflict
+        h.parallel_for(
+            sycl::nd_range<2>{{round_up(m, WG_SIZE), SG_SIZE}, {WG_SIZE, SG_SIZE}},
+            [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+            {
+                size_t g_i = item.get_group(0);
+                size_t l_i = item.get_local_id(0);
+                size_t l_j = item.get_local_id(1);
+
+                // Tiles past m or n are zero-padded so every work-item reaches the barriers.
+                T sum = 0;
+                for (size_t k = 0; k < n; k += SG_SIZE)
+                {
+                    if constexpr (a_layout == matrix_layout::row_major)
+                    {
+                        size_t row = g_i * WG_SIZE + l_i;
+                        slm[l_i][l_j] = row < m && k + l_j < n ? mat(a, ld, row, k + l_j) : T{0};
+                    }
+                    else
+                    {
+                        // transpose a tile in slm
+                        // slm[l_i][l_j] = mat(a, ld, k + l_j, g_i * WG_SIZE + l_i);
+                        size_t row = g_i * WG_SIZE + l_j;
+                        slm[l_j][l_i] = row < m && k + l_i < n ? mat(a, ld, k + l_i, row) : T{0};
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+                    if (k + l_j < n)
+                    {
+                        sum += slm[l_i][l_j] * b[k + l_j];
+                    }
+                    item.barrier(sycl::access::fence_space::local_space);
+                }
+
+                auto sg = item.get_sub_group();
+                T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
+
+                if (sg.leader() && g_i * WG_SIZE + l_i < m)
+                {
+                    c[g_i * WG_SIZE + l_i] = sg_sum;
+                }
+            });
+    }));
+}
+
+// Ping-pong version of matrix_vector_multiply_row_split_slm: the next tile of A is prefetched into the
+// second SLM buffer while the current one is consumed, with one barrier per step.
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_row_split_slm_double_buffer(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    static_assert(WG_SIZE == SG_SIZE, "WG_SIZE must be equal to SG_SIZE");
+
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    bench::track(q.submit([&](sycl::handler& h)
+    {
+        sycl::local_accessor<T, 3> slm{{2, WG_SIZE, WG_SIZE + 1}, h}; // avoid bank conflict
+        h.parallel_for(
+            sycl::nd_range<2>{{round_up(m, WG_SIZE), SG_SIZE}, {WG_SIZE, SG_SIZE}},
+            [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+            {
+                size_t g_i = item.get_group(0);
+                size_t l_i = item.get_local_id(0);
+                size_t l_j = item.get_local_id(1);
+
+                auto load_tile = [&](size_t buf, size_t k)
+                {
+                    if constexpr (a_layout == matrix_layout::row_major)
+                    {
+                        size_t row = g_i * WG_SIZE + l_i;
+                        slm[buf][l_i][l_j] = row < m && k + l_j < n ? mat(a, ld, row, k + l_j) : T{0};
+                    }
+                    else
+                    {
+                        // transpose a tile in slm
+                        size_t row = g_i * WG_SIZE + l_j;
+                        slm[buf][l_j][l_i] = row < m && k + l_i < n ? mat(a, ld, k + l_i, row) : T{0};
+                    }
+                };
+
+                load_tile(0, 0);
+                item.barrier(sycl::access::fence_space::local_space);
+
+                T sum = 0;
+                size_t buf = 0;
+                for (size_t k = 0; k < n; k += SG_SIZE)
+                {
+                    // The other buffer was released by the barrier at the end of the previous step.
+                    if (k + SG_SIZE < n)
+                    {
+                        load_tile(buf ^ 1, k + SG_SIZE);
+                    }
+
+                    if (k + l_j < n)
+                    {
+                        sum += slm[buf][l_i][l_j] * b[k + l_j];
+                    }
+
+                    item.barrier(sycl::access::fence_space::local_space);
+                    buf ^= 1;
+                }
+
+                auto sg = item.get_sub_group();
+                T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
+
+                if (sg.leader() && g_i * WG_SIZE + l_i < m)
+                {
+                    c[g_i * WG_SIZE + l_i] = sg_sum;
+                }
+            });
+    }));
+}
+
+// ACCUMULATE adds the row sums to c instead of overwriting it, used to sum column panels of A.
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE, bool ACCUMULATE = false>
+void matrix_vector_multiply_row_split_wg(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n)
+{
+    using namespace cbu;
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    // Each sub-group takes a chunk of whole SG_SIZE steps, the last non-empty chunk is cut at n.
+    size_t ele_per_sg = round_up(ceil_div(n, WG_SIZE / SG_SIZE), SG_SIZE);
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{m, WG_SIZE}, {1, WG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+
+            auto sg = item.get_sub_group();
+            size_t sg_i = sg.get_local_linear_id();
+            size_t sg_group_id = sg.get_group_id();
+            size_t start_id = sg_group_id * ele_per_sg;
+            size_t end_id = std::min(start_id + ele_per_sg, n);
+
+            T sum = 0;
+            size_t k = start_id;
+            for (; k + SG_SIZE <= end_id; k += SG_SIZE)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k + sg_i) * b[k + sg_i];
+                }
+                else
+                {
+                    sum += mat(a, ld, k + sg_i, i) * b[k + sg_i];
+                }
+            }
+            if (k + sg_i < end_id)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k + sg_i) * b[k + sg_i];
+                }
+                else
+                {
+                    sum += mat(a, ld, k + sg_i, i) * b[k + sg_i];
+                }
+            }
+
+            T sg_sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<>());
+
+            if (item.get_group().leader())
+            {
+                if constexpr (ACCUMULATE)
+                {
+                    c[i] += sg_sum;
+                }
+                else
+                {
+                    c[i] = sg_sum;
+                }
+            }
+        }));
+}
+
+// Batched GEMV on top of the row_split_sg mapping: the batch index is the slowest nd_range dimension,
+// so all problems run in one launch. operands(p) returns the (a, b, c) pointers of problem p.
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE, typename Operands>
+void matrix_vector_multiply_batch_row_split_sg(sycl::queue& q, Operands operands, size_t m, size_t n, size_t batch)
+{
+    using namespace cbu;
+    size_t ld = a_layout == matrix_layout::row_major ? n : m;
+    bench::track(q.parallel_for(
+        sycl::nd_range<3>{{batch, round_up(m, WG_SIZE), SG_SIZE}, {1, WG_SIZE, SG_SIZE}},
+        [=](sycl::nd_item<3> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            auto [a, b, c] = operands(item.get_global_id(0));
+            size_t i = item.get_global_id(1);
+
+            // sub-group-uniform exit, see matrix_vector_multiply_row_split_sg
+            if (i >= m) return;
+
+            auto sg = item.get_sub_group();
+            size_t sg_i = sg.get_local_linear_id();
+
+            T sum = 0;
+            for (size_t k = sg_i; k < n; k += SG_SIZE)
+            {
+                if constexpr (a_layout == matrix_layout::row_major)
+                {
+                    sum += mat(a, ld, i, k) * b[k];
+                }
+                else
+                {
+                    sum += mat(a, ld, k, i) * b[k];
+                }
+            }
+
+            T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
+
+            if (sg.leader())
+            {
+                c[i] = sg_sum;
+            }
+        }));
+}
+
+// Strided batch: problem p reads a + p * stride_a, b + p * stride_b and writes c + p * stride_c.
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_batch_strided_row_split_sg(sycl::queue& q, T* a, T* b, T* c, size_t m, size_t n,
+                                                       size_t batch, size_t stride_a, size_t stride_b, size_t stride_c)
+{
+    matrix_vector_multiply_batch_row_split_sg<T, a_layout, WG_SIZE, SG_SIZE>(q, [=](size_t p)
+    {
+        return std::make_tuple(a + p * stride_a, b + p * stride_b, c + p * stride_c);
+    }, m, n, batch);
+}
+
+// Pointer-array batch: a[p], b[p] and c[p] are the operands of problem p, the arrays must be device readable.
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_batch_ptr_row_split_sg(sycl::queue& q, T** a, T** b, T** c, size_t m, size_t n,
+                                                   size_t batch)
+{
+    matrix_vector_multiply_batch_row_split_sg<T, a_layout, WG_SIZE, SG_SIZE>(q, [=](size_t p)
+    {
+        return std::make_tuple(a[p], b[p], c[p]);
+    }, m, n, batch);
+}
+
+// Out-of-core GEMV: A stays in host memory and is streamed through the device buffers in tiles,
+// whole rows for row-major A and whole columns (panels) for col-major A, so only b, c and the tiles
+// have to fit on the device. Copies go to copy_q and kernels to compute_q; while
+// matrix_vector_multiply_row_split_wg works on one tile the next one is already in flight into the
+// other buffer. Row tiles write their slice of c, column panels accumulate into all of c.
+// tiles holds the device buffers (two for double buffering), tile_size elements each.
+// Only submits, wait on compute_q for the result.
+template <typename T, cbu::matrix_layout a_layout, size_t WG_SIZE, size_t SG_SIZE>
+void matrix_vector_multiply_streaming(sycl::queue& compute_q, sycl::queue& copy_q, const T* a, T* b, T* c,
+                                      size_t m, size_t n, const std::vector<T*>& tiles, size_t tile_size)
+{
+    using namespace cbu;
+    constexpr bool row_major = a_layout == matrix_layout::row_major;
+    size_t lines = row_major ? m : n; // rows or columns of A
+    size_t line_size = row_major ? n : m;
+    if (tiles.empty() || tile_size < line_size)
+    {
+        throw std::invalid_argument("matrix_vector_multiply_streaming: a tile must hold at least one line of A");
+    }
+    size_t lines_per_tile = tile_size / line_size;
+
+    // last kernel that read each buffer, the next copy into it waits for that kernel
+    std::vector<sycl::event> released(tiles.size());
+    for (size_t t = 0, first = 0; first < lines; t++, first += lines_per_tile)
+    {
+        size_t count = std::min(lines_per_tile, lines - first);
+        size_t buf = t % tiles.size();
+        T* tile = tiles[buf];
+
+        sycl::event copied = bench::track(copy_q.memcpy(tile, a + first * line_size, count * line_size * sizeof(T), released[buf]));
+        compute_q.ext_oneapi_submit_barrier({copied});
+        if constexpr (row_major)
+        {
+            matrix_vector_multiply_row_split_wg<T, a_layout, WG_SIZE, SG_SIZE>(compute_q, tile, b, c + first, count, n);
+        }
+        else if (t == 0)
+        {
+            matrix_vector_multiply_row_split_wg<T, a_layout, WG_SIZE, SG_SIZE>(compute_q, tile, b, c, m, count);
+        }
+        else
+        {
+            matrix_vector_multiply_row_split_wg<T, a_layout, WG_SIZE, SG_SIZE, true>(
+                compute_q, tile, b + first, c, m, count);
+        }
+        released[buf] = compute_q.ext_oneapi_submit_barrier();
+    }
+}
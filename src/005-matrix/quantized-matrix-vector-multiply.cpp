@@ -0,0 +1,127 @@
+#include <cmath>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-vector-multiply.hpp"
+#include "005-matrix/quantized-matrix-vector-multiply.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Row-major GEMV with A quantized to int8 and int4 against the float kernels (row_split_wg is the baseline):
+//   per-row scales        one scale per row
+//   per-group scales      one scale per --group_size elements of a row
+// GB/s counts the bytes actually moved (quantized A, scales, b and c), so the speedup shows how much of the
+// 4x / 8x traffic reduction survives dequantization. Accuracy is the quantized product against the float one.
+
+constexpr size_t sg_size = 32;
+
+template <typename T>
+void log_accuracy(bench::Driver& driver, const std::string& name, const std::vector<T>& c,
+                  const std::vector<T>& c_float)
+{
+    double max_abs = 0, err2 = 0, ref2 = 0;
+    for (size_t i = 0; i < c.size(); i++)
+    {
+        double d = static_cast<double>(c[i]) - c_float[i];
+        max_abs = std::max(max_abs, std::abs(d));
+        err2 += d * d;
+        ref2 += static_cast<double>(c_float[i]) * c_float[i];
+    }
+    driver.log() << "\t" << name << " vs float: max abs err " << max_abs << ", rel L2 err "
+        << std::sqrt(err2 / std::max(ref2, 1e-30)) << "\n";
+}
+
+template <typename T, size_t BITS>
+void test_quantized(bench::Driver& driver, const std::vector<T>& a, const std::vector<T>& b,
+                    const std::vector<T>& c_float, T* d_b, T* d_c, size_t m, size_t n, size_t group_size)
+{
+    using namespace cbu;
+    std::string prefix = "quantized_matrix_vector_multiply_int" + std::to_string(BITS);
+
+    QuantizedMatrix qa = quantize_matrix(a.data(), m, n, BITS, group_size);
+    std::vector<T> c(m);
+    quantized_matrix_vector_multiply_ref(qa, b.data(), c.data());
+    log_accuracy(driver, "int" + std::to_string(BITS), c, c_float);
+
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    auto* d_qa = pool.malloc_device<uint8_t>(qa.data.size(), q);
+    auto* d_scales = pool.malloc_device<float>(qa.scales.size(), q);
+    q.memcpy(d_qa, qa.data.data(), qa.data.size()).wait();
+    q.memcpy(d_scales, qa.scales.data(), qa.scales.size() * sizeof(float)).wait();
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = qa.bytes() + (n + m) * sizeof(T),
+        .total_flop = 2 * m * n,
+    };
+
+    using func_t = std::function<void(sycl::queue&, const uint8_t*, const float*, T*, T*, size_t, size_t, size_t,
+                                      size_t)>;
+    std::vector<std::tuple<std::string, func_t>> funcs{
+        {prefix + "_row_split_sg", quantized_matrix_vector_multiply_row_split_sg<T, BITS, 32, sg_size>},
+        {prefix + "_row_split_wg", quantized_matrix_vector_multiply_row_split_wg<T, BITS, 256, sg_size>},
+    };
+
+    driver.run_all(funcs, opt,
+                   [&](func_t& func) { func(q, d_qa, d_scales, d_b, d_c, m, n, qa.ld, qa.group_size); },
+                   [&] { q.fill(d_c, T{0}, m).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    pool.free(d_qa, q);
+    pool.free(d_scales, q);
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace cbu;
+    using dtype = float;
+    constexpr auto row_major = matrix_layout::row_major;
+
+    bench::Driver driver{argc, argv};
+    size_t m = driver.arg("m", 512 * 1024), n = driver.arg("n", 1024);
+
+    std::vector<dtype> a(m * n), b(n), c(m);
+    random_fill(a);
+    random_fill(b);
+
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    auto* d_a = pool.malloc_device<dtype>(a.size(), q);
+    auto* d_b = pool.malloc_device<dtype>(b.size(), q);
+    auto* d_c = pool.malloc_device<dtype>(c.size(), q);
+    q.memcpy(d_a, a.data(), a.size() * sizeof(dtype)).wait();
+    q.memcpy(d_b, b.data(), b.size() * sizeof(dtype)).wait();
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = (m * n + n + m) * sizeof(dtype),
+        .total_flop = 2 * m * n,
+    };
+    matrix_vector_multiply_ref<dtype, row_major>(a.data(), b.data(), c.data(), m, n);
+
+    // the float kernels do not depend on the scale granularity, so they run once and serve both sections
+    const std::string float_section = "float";
+    driver.section(float_section);
+    using func_t = std::function<void(sycl::queue&, dtype*, dtype*, dtype*, size_t, size_t)>;
+    std::vector<std::tuple<std::string, func_t>> funcs{
+        {"matrix_vector_multiply_row_split_sg", matrix_vector_multiply_row_split_sg<dtype, row_major, 32, sg_size>},
+        {"matrix_vector_multiply_row_split_wg", matrix_vector_multiply_row_split_wg<dtype, row_major, 256, sg_size>},
+    };
+    driver.run_all(funcs, opt,
+                   [&](func_t& func) { func(q, d_a, d_b, d_c, m, n); },
+                   [&] { q.fill(d_c, dtype{0}, c.size()).wait(); },
+                   [&] { sycl_acc_check(q, c, d_c); });
+
+    for (size_t group_size: {size_t{0}, driver.arg("group_size", 128)})
+    {
+        driver.section(group_size == 0 ? "per-row scales" : "per-group scales, " + std::to_string(group_size));
+        driver.baseline("matrix_vector_multiply_row_split_wg", float_section);
+
+        test_quantized<dtype, 8>(driver, a, b, c, d_b, d_c, m, n, group_size);
+        test_quantized<dtype, 4>(driver, a, b, c, d_b, d_c, m, n, group_size);
+    }
+
+    pool.free(d_a, q);
+    pool.free(d_b, q);
+    pool.free(d_c, q);
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+
+// Weight-quantized GEMV: A [m, n] row-major stored as signed BITS-bit integers (8, or 4 packed two per
+// byte) with one float scale per group of group_size consecutive elements of a row, a group of the whole
+// row being per-row scales. Symmetric quantization: A[i][k] ~= q[i][k] * scale[i][k / group_size].
+//
+// Rows are padded to a multiple of 8 elements, so every work-item reads aligned 32-bit words (4 int8 or
+// 8 int4 values), unpacks them in registers and accumulates q * b per group before applying the scale.
+// A moves 4x (int8) or 8x (int4) fewer bytes than float, plus the scales.
+
+struct QuantizedMatrix
+{
+    size_t m = 0, n = 0, bits = 8, group_size = 0;
+    size_t ld = 0; // bytes per row
+    std::vector<uint8_t> data; // [m][ld]
+    std::vector<float> scales; // [m][groups()]
+
+    size_t groups() const { return ceil_div(n, group_size); }
+    size_t bytes() const { return data.size() + scales.size() * sizeof(float); }
+};
+
+// group_size = 0 means one scale per row; otherwise it must be a multiple of 8.
+template <typename T>
+QuantizedMatrix quantize_matrix(const T* a, size_t m, size_t n, size_t bits, size_t group_size = 0)
+{
+    if (bits != 8 && bits != 4) throw std::invalid_argument("quantize_matrix supports 8 and 4 bits");
+    if (group_size == 0) group_size = round_up(n, 8);
+    if (group_size % 8 != 0) throw std::invalid_argument("group_size must be a multiple of 8");
+
+    QuantizedMatrix qa{m, n, bits, group_size, round_up(n, 8) * bits / 8};
+    qa.data.assign(m * qa.ld, 0);
+    qa.scales.resize(m * qa.groups());
+    int q_max = (1 << (bits - 1)) - 1; // symmetric, -q_max..q_max
+    for (size_t i = 0; i < m; i++)
+    {
+        for (size_t g = 0; g < qa.groups(); g++)
+        {
+            size_t start = g * group_size, end = std::min(start + group_size, n);
+            float amax = 0;
+            for (size_t k = start; k < end; k++)
+            {
+                amax = std::max(amax, std::abs(static_cast<float>(a[i * n + k])));
+            }
+            float scale = amax > 0 ? amax / q_max : 1.0f;
+            qa.scales[i * qa.groups() + g] = scale;
+            for (size_t k = start; k < end; k++)
+            {
+                int v = static_cast<int>(std::lround(static_cast<float>(a[i * n + k]) / scale));
+                v = std::clamp(v, -q_max, q_max);
+                uint8_t& byte = qa.data[i * qa.ld + k * bits / 8];
+                if (bits == 8)
+                {
+                    byte = static_cast<uint8_t>(static_cast<int8_t>(v));
+                }
+                else
+                {
+                    int shift = k % 2 * 4; // element 2j in the low nibble, 2j + 1 in the high one
+                    byte |= static_cast<uint8_t>((v & 0xF) << shift);
+                }
+            }
+        }
+    }
+    return qa;
+}
+
+// Signed value j of a little-endian word of 32 / BITS packed values.
+template <size_t BITS>
+inline int unpack_quantized(uint32_t word, size_t j)
+{
+    return static_cast<int32_t>(word << (32 - BITS * (j + 1))) >> (32 - BITS);
+}
+
+template <size_t BITS>
+inline uint32_t load_quantized_word(const uint8_t* row, size_t k)
+{
+    uint32_t word;
+    std::memcpy(&word, row + k * BITS / 8, sizeof(word));
+    return word;
+}
+
+// GEMV on the dequantized values, the expected result of the kernels.
+template <typename T>
+void quantized_matrix_vector_multiply_ref(const QuantizedMatrix& a, const T* b, T* c)
+{
+    bench::host_parallel_for(a.m, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            T sum = 0;
+            for (size_t k = 0; k < a.n; k++)
+            {
+                uint8_t byte = a.data[i * a.ld + k * a.bits / 8];
+                int v = a.bits == 8 ? static_cast<int8_t>(byte) : unpack_quantized<4>(byte, k % 2);
+                sum += static_cast<T>(v * a.scales[i * a.groups() + k / a.group_size]) * b[k];
+            }
+            c[i] = sum;
+        }
+    }, 64);
+}
+
+// Partial dot product of one quantized row with b, the work-item `lane` of `lanes` taking every
+// lanes-th word of each group.
+template <typename T, size_t BITS>
+inline T quantized_row_dot(const uint8_t* row, const float* row_scales, const T* b, size_t n, size_t group_size,
+                           size_t lane, size_t lanes)
+{
+    constexpr size_t per_word = 32 / BITS;
+    T sum = 0;
+    for (size_t start = 0, g = 0; start < n; start += group_size, g++)
+    {
+        size_t end = std::min(start + group_size, n);
+        T acc = 0;
+        for (size_t k = start + lane * per_word; k < end; k += lanes * per_word)
+        {
+            uint32_t word = load_quantized_word<BITS>(row, k);
+#pragma unroll
+            for (size_t j = 0; j < per_word; j++)
+            {
+                if (k + j < end)
+                {
+                    acc += static_cast<T>(unpack_quantized<BITS>(word, j)) * b[k + j];
+                }
+            }
+        }
+        sum += acc * static_cast<T>(row_scales[g]);
+    }
+    return sum;
+}
+
+// Sub-group per row, as matrix_vector_multiply_row_split_sg.
+template <typename T, size_t BITS, size_t WG_SIZE, size_t SG_SIZE>
+void quantized_matrix_vector_multiply_row_split_sg(sycl::queue& q, const uint8_t* a, const float* scales, T* b, T* c,
+                                                   size_t m, size_t n, size_t ld, size_t group_size)
+{
+    size_t groups = ceil_div(n, group_size);
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), SG_SIZE}, {WG_SIZE, SG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+
+            // sub-group-uniform exit, see matrix_vector_multiply_row_split_sg
+            if (i >= m) return;
+
+            auto sg = item.get_sub_group();
+            T sum = quantized_row_dot<T, BITS>(a + i * ld, scales + i * groups, b, n, group_size,
+                                               sg.get_local_linear_id(), SG_SIZE);
+            T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
+
+            if (sg.leader())
+            {
+                c[i] = sg_sum;
+            }
+        }));
+}
+
+// Work-group per row, as matrix_vector_multiply_row_split_wg.
+template <typename T, size_t BITS, size_t WG_SIZE, size_t SG_SIZE>
+void quantized_matrix_vector_multiply_row_split_wg(sycl::queue& q, const uint8_t* a, const float* scales, T* b, T* c,
+                                                   size_t m, size_t n, size_t ld, size_t group_size)
+{
+    size_t groups = ceil_div(n, group_size);
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{m, WG_SIZE}, {1, WG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+            T sum = quantized_row_dot<T, BITS>(a + i * ld, scales + i * groups, b, n, group_size,
+                                               item.get_local_id(1), WG_SIZE);
+            T wg_sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<>());
+
+            if (item.get_group().leader())
+            {
+                c[i] = wg_sum;
+            }
+        }));
+}
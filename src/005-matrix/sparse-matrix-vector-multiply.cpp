@@ -0,0 +1,241 @@
+#include <cmath>
+#include <random>
+#include <sycl/sycl.hpp>
+#include <oneapi/mkl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+#include "005-matrix/matrix-vector-multiply.hpp"
+#include "005-matrix/sparse-matrix-vector-multiply.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Sparse GEMV against oneapi::mkl::sparse::gemv (the baseline of every section):
+//   uniform        --dense_n x --dense_n dense matrix with --density_permille nonzeros, converted dense -> COO -> CSR
+//   power-law      --sparse_n x --sparse_n, row lengths from a Pareto(1.5) tail with the same mean density, built as COO
+// GB/s counts the CSR bytes (values, column indices, row pointers, b and c) for every format, so the
+// numbers compare as the effective bandwidth per nonzero; padded formats move more than that.
+// ELLPACK is skipped when padding would blow it up beyond --ell_max_padding times the nonzeros.
+
+// Owns a oneMKL CSR handle over device arrays.
+template <typename T>
+class MklCsr
+{
+public:
+    MklCsr(sycl::queue& q, sparse_index* row_ptr, sparse_index* col, T* val, size_t m, size_t n) : q(q)
+    {
+        oneapi::mkl::sparse::init_matrix_handle(&handle);
+        oneapi::mkl::sparse::set_csr_data(q, handle, static_cast<sparse_index>(m), static_cast<sparse_index>(n),
+                                          oneapi::mkl::index_base::zero, row_ptr, col, val).wait();
+        oneapi::mkl::sparse::optimize_gemv(q, oneapi::mkl::transpose::nontrans, handle).wait();
+    }
+
+    MklCsr(const MklCsr&) = delete;
+    MklCsr& operator=(const MklCsr&) = delete;
+
+    ~MklCsr()
+    {
+        oneapi::mkl::sparse::release_matrix_handle(q, &handle).wait();
+    }
+
+    void gemv(T* b, T* c)
+    {
+        bench::track(oneapi::mkl::sparse::gemv(q, oneapi::mkl::transpose::nontrans, T{1}, handle, b, T{0}, c));
+    }
+
+private:
+    sycl::queue& q;
+    oneapi::mkl::sparse::matrix_handle_t handle = nullptr;
+};
+
+template <typename U>
+U* upload(sycl::queue& q, const std::vector<U>& host)
+{
+    U* d = bench::usm_pool().malloc_device<U>(std::max<size_t>(host.size(), 1), q);
+    q.memcpy(d, host.data(), host.size() * sizeof(U)).wait();
+    return d;
+}
+
+template <typename T>
+CooMatrix<T> power_law_coo(size_t m, size_t n, double density, std::mt19937& rng)
+{
+    // Pareto(alpha) has mean x_min * alpha / (alpha - 1)
+    constexpr double alpha = 1.5;
+    double x_min = density * n * (alpha - 1) / alpha;
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::uniform_int_distribution<sparse_index> column(0, static_cast<sparse_index>(n - 1));
+    std::uniform_real_distribution<T> value(-1, 1);
+
+    CooMatrix<T> coo{m, n};
+    std::vector<sparse_index> cols;
+    for (size_t i = 0; i < m; i++)
+    {
+        double len = std::ceil(x_min / std::pow(1.0 - u(rng), 1.0 / alpha));
+        cols.resize(static_cast<size_t>(std::min(len, static_cast<double>(n))));
+        for (auto& j: cols)
+        {
+            j = column(rng);
+        }
+        std::sort(cols.begin(), cols.end());
+        cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+        for (sparse_index j: cols)
+        {
+            coo.row.push_back(static_cast<sparse_index>(i));
+            coo.col.push_back(j);
+            coo.val.push_back(value(rng));
+        }
+    }
+    return coo;
+}
+
+template <typename T>
+void test_sparse_matrix_vector_multiply(bench::Driver& driver, const CsrMatrix<T>& csr, const std::vector<T>& b,
+                                        std::vector<T>& c)
+{
+    using namespace cbu;
+    constexpr size_t sg_size = 32;
+
+    size_t m = csr.m, n = csr.n, nnz = csr.nnz();
+    size_t width = csr_max_row_length(csr);
+    size_t sigma = driver.arg("sigma", 256);
+    driver.log() << "\tnnz: " << nnz << ", avg row: " << nnz / std::max<size_t>(m, 1) << ", max row: " << width
+        << ", density: " << 100.0 * nnz / (static_cast<double>(m) * n) << "%\n";
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = nnz * (sizeof(T) + sizeof(sparse_index)) + (m + 1) * sizeof(sparse_index)
+                           + (n + m) * sizeof(T),
+        .total_flop = 2 * nnz,
+    };
+
+    sycl::queue& q = driver.queue();
+    auto& pool = bench::usm_pool();
+    auto* d_row_ptr = upload(q, csr.row_ptr);
+    auto* d_col = upload(q, csr.col);
+    auto* d_val = upload(q, csr.val);
+    auto* d_b = upload(q, b);
+    auto* d_c = pool.malloc_device<T>(m, q);
+
+    auto reset = [&] { q.fill(d_c, T{0}, m).wait(); };
+    auto check = [&] { sycl_acc_check(q, c, d_c); };
+
+    {
+        MklCsr<T> mkl{q, d_row_ptr, d_col, d_val, m, n};
+        reset();
+        driver.run("sparse_matrix_vector_multiply_mkl", [&]
+        {
+            mkl.gemv(d_b, d_c);
+            q.wait();
+        }, opt, check);
+        driver.baseline("sparse_matrix_vector_multiply_mkl");
+    }
+
+    using func_t = std::function<void(sycl::queue&)>;
+    std::vector<std::tuple<std::string, func_t>> funcs{
+        {
+            "sparse_matrix_vector_multiply_csr_naive", [&](sycl::queue& q)
+            {
+                sparse_matrix_vector_multiply_csr_naive(q, d_row_ptr, d_col, d_val, d_b, d_c, m);
+            }
+        },
+        {
+            "sparse_matrix_vector_multiply_csr_row_split_sg", [&](sycl::queue& q)
+            {
+                sparse_matrix_vector_multiply_csr_row_split_sg<T, 32, sg_size>(q, d_row_ptr, d_col, d_val, d_b, d_c, m);
+            }
+        },
+        {
+            "sparse_matrix_vector_multiply_csr_row_split_wg", [&](sycl::queue& q)
+            {
+                sparse_matrix_vector_multiply_csr_row_split_wg<T, 256, sg_size>(q, d_row_ptr, d_col, d_val, d_b, d_c, m);
+            }
+        },
+    };
+
+    // padded formats
+    size_t ell_max_padding = driver.arg("ell_max_padding", 4);
+    sparse_index *d_ell_col = nullptr, *d_sell_col = nullptr, *d_sell_perm = nullptr;
+    T *d_ell_val = nullptr, *d_sell_val = nullptr;
+    size_t* d_sell_ptr = nullptr;
+    if (width * m <= ell_max_padding * nnz)
+    {
+        EllMatrix<T> ell = ell_from_csr(csr);
+        d_ell_col = upload(q, ell.col);
+        d_ell_val = upload(q, ell.val);
+        funcs.emplace_back("sparse_matrix_vector_multiply_ell", [&](sycl::queue& q)
+        {
+            sparse_matrix_vector_multiply_ell<T, 256, sg_size>(q, d_ell_col, d_ell_val, d_b, d_c, m, width);
+        });
+    }
+    else
+    {
+        driver.log() << "\tsparse_matrix_vector_multiply_ell skipped: " << width * m / std::max<size_t>(nnz, 1)
+            << "x the nonzeros after padding\n";
+    }
+
+    SellMatrix<T> sell = sell_from_csr(csr, sg_size, sigma);
+    driver.log() << "\tSELL-" << sg_size << "-" << sell.sigma << " padding: "
+        << static_cast<double>(sell.val.size()) / std::max<size_t>(nnz, 1) << "x the nonzeros\n";
+    d_sell_ptr = upload(q, sell.slice_ptr);
+    d_sell_perm = upload(q, sell.perm);
+    d_sell_col = upload(q, sell.col);
+    d_sell_val = upload(q, sell.val);
+    funcs.emplace_back("sparse_matrix_vector_multiply_sell", [&](sycl::queue& q)
+    {
+        sparse_matrix_vector_multiply_sell<T, 256, sg_size>(q, d_sell_ptr, d_sell_perm, d_sell_col, d_sell_val,
+                                                          d_b, d_c, m);
+    });
+
+    driver.run_all(funcs, opt, [&](func_t& func) { func(q); }, reset, check);
+
+    for (void* ptr: std::initializer_list<void*>{
+             d_row_ptr, d_col, d_val, d_b, d_c, d_ell_col, d_ell_val, d_sell_ptr, d_sell_perm, d_sell_col, d_sell_val
+         })
+    {
+        if (ptr) pool.free(ptr, q);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace cbu;
+    using dtype = float;
+
+    bench::Driver driver{argc, argv};
+    double density = driver.arg("density_permille", 10) / 1000.0;
+    std::mt19937 rng{42};
+
+    {
+        driver.section("uniform, from dense");
+        size_t n = driver.arg("dense_n", 8 * 1024);
+        std::vector<dtype> a(n * n, dtype{0}), b(n), c(n);
+        std::bernoulli_distribution nonzero(density);
+        std::uniform_real_distribution<dtype> value(-1, 1);
+        for (auto& x: a)
+        {
+            if (nonzero(rng)) x = value(rng);
+        }
+        random_fill(b);
+
+        CsrMatrix<dtype> csr = csr_from_dense(a.data(), n, n);
+        // the dense product also checks the conversion
+        driver.run_ref("matrix_vector_multiply_ref", [&]
+        {
+            matrix_vector_multiply_ref<dtype, matrix_layout::row_major>(a.data(), b.data(), c.data(), n, n);
+        }, {.total_mem_bytes = (n * n + 2 * n) * sizeof(dtype), .total_flop = 2 * n * n});
+        test_sparse_matrix_vector_multiply(driver, csr, b, c);
+    }
+
+    {
+        driver.section("power-law rows, from coo");
+        size_t n = driver.arg("sparse_n", 32 * 1024);
+        CsrMatrix<dtype> csr = csr_from_coo(power_law_coo<dtype>(n, n, density, rng));
+        std::vector<dtype> b(n), c(n);
+        random_fill(b);
+        driver.run_ref("sparse_matrix_vector_multiply_ref", [&]
+        {
+            sparse_matrix_vector_multiply_ref(csr, b.data(), c.data());
+        }, {.total_flop = 2 * csr.nnz()});
+        test_sparse_matrix_vector_multiply(driver, csr, b, c);
+    }
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+
+// A sparse matrix: [m, n], b vector: [n], c = A x b : [m]
+//
+// Host formats and conversions:
+//   COO        (row, col, val) triplets in any order, e.g. from a dense matrix
+//   CSR        row_ptr[m + 1], col[nnz], val[nnz], columns sorted within a row
+//   ELLPACK    every row padded to the longest one, stored column-major so consecutive rows are adjacent
+//   SELL-C-σ   rows sorted by length within windows of σ rows, cut into slices of C rows, each slice
+//              padded to its own longest row and stored column-major
+// Padding entries have column 0 and value 0, so kernels need no mask.
+//
+// The kernels follow the dense mappings of matrix-vector-multiply.hpp: a sub-group per row (row_split_sg),
+// a work-group per row (row_split_wg), and a work-item per row for the padded formats, where a
+// sub-group then reads C adjacent rows at once.
+
+using sparse_index = std::int32_t;
+
+template <typename T>
+struct CooMatrix
+{
+    size_t m = 0, n = 0;
+    std::vector<sparse_index> row, col;
+    std::vector<T> val;
+
+    size_t nnz() const { return val.size(); }
+};
+
+template <typename T>
+struct CsrMatrix
+{
+    size_t m = 0, n = 0;
+    std::vector<sparse_index> row_ptr, col;
+    std::vector<T> val;
+
+    size_t nnz() const { return val.size(); }
+};
+
+template <typename T>
+struct EllMatrix
+{
+    size_t m = 0, n = 0, width = 0;
+    std::vector<sparse_index> col; // [width][m]
+    std::vector<T> val;
+};
+
+template <typename T>
+struct SellMatrix
+{
+    size_t m = 0, n = 0, c = 0, sigma = 0;
+    std::vector<sparse_index> perm; // perm[r] = original row stored at position r
+    std::vector<size_t> slice_ptr; // [m / c + 1], offset of every slice in col/val
+    std::vector<sparse_index> col; // per slice [width][c]
+    std::vector<T> val;
+};
+
+template <typename T>
+CooMatrix<T> coo_from_dense(const T* a, size_t m, size_t n)
+{
+    CooMatrix<T> coo{m, n};
+    for (size_t i = 0; i < m; i++)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            if (a[i * n + j] != T{0})
+            {
+                coo.row.push_back(static_cast<sparse_index>(i));
+                coo.col.push_back(static_cast<sparse_index>(j));
+                coo.val.push_back(a[i * n + j]);
+            }
+        }
+    }
+    return coo;
+}
+
+// Duplicate (row, col) entries are kept as separate nonzeros, they sum up in the product.
+template <typename T>
+CsrMatrix<T> csr_from_coo(const CooMatrix<T>& coo)
+{
+    if (coo.nnz() > static_cast<size_t>(std::numeric_limits<sparse_index>::max()))
+    {
+        throw std::length_error("nnz does not fit sparse_index");
+    }
+    std::vector<size_t> order(coo.nnz());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y)
+    {
+        return std::tie(coo.row[x], coo.col[x]) < std::tie(coo.row[y], coo.col[y]);
+    });
+
+    CsrMatrix<T> csr{coo.m, coo.n};
+    csr.row_ptr.assign(coo.m + 1, 0);
+    csr.col.reserve(coo.nnz());
+    csr.val.reserve(coo.nnz());
+    for (size_t e: order)
+    {
+        csr.row_ptr[coo.row[e] + 1]++;
+        csr.col.push_back(coo.col[e]);
+        csr.val.push_back(coo.val[e]);
+    }
+    std::partial_sum(csr.row_ptr.begin(), csr.row_ptr.end(), csr.row_ptr.begin());
+    return csr;
+}
+
+template <typename T>
+CsrMatrix<T> csr_from_dense(const T* a, size_t m, size_t n)
+{
+    return csr_from_coo(coo_from_dense(a, m, n));
+}
+
+template <typename T>
+size_t csr_max_row_length(const CsrMatrix<T>& csr)
+{
+    size_t width = 0;
+    for (size_t i = 0; i < csr.m; i++)
+    {
+        width = std::max<size_t>(width, csr.row_ptr[i + 1] - csr.row_ptr[i]);
+    }
+    return width;
+}
+
+template <typename T>
+EllMatrix<T> ell_from_csr(const CsrMatrix<T>& csr)
+{
+    EllMatrix<T> ell{csr.m, csr.n, csr_max_row_length(csr)};
+    ell.col.assign(ell.width * ell.m, 0);
+    ell.val.assign(ell.width * ell.m, T{0});
+    for (size_t i = 0; i < csr.m; i++)
+    {
+        for (sparse_index k = csr.row_ptr[i]; k < csr.row_ptr[i + 1]; k++)
+        {
+            size_t j = k - csr.row_ptr[i];
+            ell.col[j * ell.m + i] = csr.col[k];
+            ell.val[j * ell.m + i] = csr.val[k];
+        }
+    }
+    return ell;
+}
+
+// sigma = 1 keeps the row order (SELL-C), sigma = m sorts globally; sigma is rounded up to a multiple of c.
+template <typename T>
+SellMatrix<T> sell_from_csr(const CsrMatrix<T>& csr, size_t c, size_t sigma)
+{
+    sigma = round_up(std::max<size_t>(sigma, 1), c);
+    SellMatrix<T> sell{csr.m, csr.n, c, sigma};
+    auto length = [&](sparse_index i) { return csr.row_ptr[i + 1] - csr.row_ptr[i]; };
+
+    sell.perm.resize(csr.m);
+    std::iota(sell.perm.begin(), sell.perm.end(), 0);
+    for (size_t w = 0; w < csr.m; w += sigma)
+    {
+        auto end = sell.perm.begin() + std::min(w + sigma, csr.m);
+        std::stable_sort(sell.perm.begin() + w, end, [&](sparse_index x, sparse_index y)
+        {
+            return length(x) > length(y);
+        });
+    }
+
+    size_t slices = ceil_div(csr.m, c);
+    sell.slice_ptr.assign(slices + 1, 0);
+    for (size_t s = 0; s < slices; s++)
+    {
+        size_t width = 0;
+        for (size_t r = s * c; r < std::min((s + 1) * c, csr.m); r++)
+        {
+            width = std::max<size_t>(width, length(sell.perm[r]));
+        }
+        sell.slice_ptr[s + 1] = sell.slice_ptr[s] + width * c;
+    }
+    sell.col.assign(sell.slice_ptr[slices], 0);
+    sell.val.assign(sell.slice_ptr[slices], T{0});
+    for (size_t r = 0; r < csr.m; r++)
+    {
+        size_t s = r / c, lane = r % c;
+        sparse_index i = sell.perm[r];
+        for (sparse_index k = csr.row_ptr[i]; k < csr.row_ptr[i + 1]; k++)
+        {
+            size_t e = sell.slice_ptr[s] + (k - csr.row_ptr[i]) * c + lane;
+            sell.col[e] = csr.col[k];
+            sell.val[e] = csr.val[k];
+        }
+    }
+    return sell;
+}
+
+template <typename T>
+void sparse_matrix_vector_multiply_ref(const CsrMatrix<T>& a, const T* b, T* c)
+{
+    bench::host_parallel_for(a.m, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            T sum = 0;
+            for (sparse_index k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+            {
+                sum += a.val[k] * b[a.col[k]];
+            }
+            c[i] = sum;
+        }
+    }, 256);
+}
+
+// Scalar CSR: a work-item per row, neighbouring work-items read far apart.
+template <typename T>
+void sparse_matrix_vector_multiply_csr_naive(sycl::queue& q, const sparse_index* row_ptr, const sparse_index* col,
+                                             const T* val, T* b, T* c, size_t m)
+{
+    bench::track(q.parallel_for(
+        sycl::range<1>(m),
+        [=](sycl::id<1> i)
+        {
+            T sum = 0;
+            for (sparse_index k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+            {
+                sum += val[k] * b[col[k]];
+            }
+            c[i] = sum;
+        }));
+}
+
+// Vector CSR: a sub-group per row, the lanes read SG_SIZE consecutive nonzeros per step.
+template <typename T, size_t WG_SIZE, size_t SG_SIZE>
+void sparse_matrix_vector_multiply_csr_row_split_sg(sycl::queue& q, const sparse_index* row_ptr,
+                                                    const sparse_index* col, const T* val, T* b, T* c, size_t m)
+{
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{round_up(m, WG_SIZE), SG_SIZE}, {WG_SIZE, SG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+
+            // sub-group-uniform exit, see matrix_vector_multiply_row_split_sg
+            if (i >= m) return;
+
+            auto sg = item.get_sub_group();
+            size_t sg_i = sg.get_local_linear_id();
+
+            T sum = 0;
+            for (sparse_index k = row_ptr[i] + sg_i; k < row_ptr[i + 1]; k += SG_SIZE)
+            {
+                sum += val[k] * b[col[k]];
+            }
+
+            T sg_sum = sycl::reduce_over_group(sg, sum, sycl::plus<>());
+
+            if (sg.leader())
+            {
+                c[i] = sg_sum;
+            }
+        }));
+}
+
+// A work-group per row, for the long rows of power-law matrices.
+template <typename T, size_t WG_SIZE, size_t SG_SIZE>
+void sparse_matrix_vector_multiply_csr_row_split_wg(sycl::queue& q, const sparse_index* row_ptr,
+                                                    const sparse_index* col, const T* val, T* b, T* c, size_t m)
+{
+    bench::track(q.parallel_for(
+        sycl::nd_range<2>{{m, WG_SIZE}, {1, WG_SIZE}},
+        [=](sycl::nd_item<2> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+            size_t l_i = item.get_local_id(1);
+
+            T sum = 0;
+            for (sparse_index k = row_ptr[i] + l_i; k < row_ptr[i + 1]; k += WG_SIZE)
+            {
+                sum += val[k] * b[col[k]];
+            }
+
+            T wg_sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<>());
+
+            if (item.get_group().leader())
+            {
+                c[i] = wg_sum;
+            }
+        }));
+}
+
+// ELLPACK: a work-item per row, the column-major layout makes every step of a sub-group contiguous.
+template <typename T, size_t WG_SIZE, size_t SG_SIZE>
+void sparse_matrix_vector_multiply_ell(sycl::queue& q, const sparse_index* col, const T* val, T* b, T* c,
+                                       size_t m, size_t width)
+{
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(m, WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t i = item.get_global_id(0);
+            if (i >= m) return;
+
+            T sum = 0;
+            for (size_t j = 0; j < width; j++)
+            {
+                sum += val[j * m + i] * b[col[j * m + i]];
+            }
+            c[i] = sum;
+        }));
+}
+
+// SELL-C-σ with C = SG_SIZE: a sub-group per slice and a lane per row, so a sub-group only runs as long
+// as the longest row of its own slice. perm scatters the results back to the original row order.
+template <typename T, size_t WG_SIZE, size_t SG_SIZE>
+void sparse_matrix_vector_multiply_sell(sycl::queue& q, const size_t* slice_ptr, const sparse_index* perm,
+                                        const sparse_index* col, const T* val, T* b, T* c, size_t m)
+{
+    bench::track(q.parallel_for(
+        sycl::nd_range<1>{round_up(m, WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]]
+        {
+            size_t r = item.get_global_id(0);
+            if (r >= m) return;
+
+            size_t s = r / SG_SIZE, lane = r % SG_SIZE;
+            T sum = 0;
+            for (size_t e = slice_ptr[s] + lane; e < slice_ptr[s + 1]; e += SG_SIZE)
+            {
+                sum += val[e] * b[col[e]];
+            }
+            c[perm[r]] = sum;
+        }));
+}
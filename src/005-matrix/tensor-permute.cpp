@@ -0,0 +1,127 @@
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "004-vector/vector-copy.hpp"
+#include "005-matrix/tensor-permute.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Layout conversions at achieved bandwidth, each against a plain copy of the same bytes (the baseline):
+//   NCHW -> NHWC and back          --n --c --h --w
+//   batched transpose [b,m,k]      --batch --m --k
+//   6-d permute                    fixed shape of about 4M elements
+//   in-place square transpose      --batch --square
+
+
+constexpr size_t tile_size = 32;
+constexpr size_t sg_size = 32;
+
+template<typename T>
+void test_tensor_permute(bench::Driver &driver, const std::string &name, const std::vector<size_t> &shape,
+                         const std::vector<size_t> &perm) {
+    using namespace cbu;
+    driver.section(name);
+
+    PermuteDesc desc = make_permute_desc(shape, perm);
+    size_t size = desc.size;
+    std::vector<T> in(size), out(size);
+    random_fill(in);
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = 2 * size * sizeof(T),
+    };
+    driver.run_ref("tensor_permute_ref", [&] { tensor_permute_ref(in.data(), out.data(), desc); }, opt);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_in = pool.malloc_device<T>(size, q);
+    auto *d_out = pool.malloc_device<T>(size, q);
+    q.memcpy(d_in, in.data(), size * sizeof(T)).wait();
+
+    driver.run("vector_copy_with_vec", [&] {
+        vector_copy_with_vec<T, 256, sg_size, 4>(q, d_in, d_out, size);
+        q.wait();
+    }, opt);
+    driver.baseline("vector_copy_with_vec");
+
+    using func_t = std::function<void(sycl::queue &, T *, T *, const PermuteDesc &)>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {"tensor_permute_naive", tensor_permute_naive<T>},
+        {"tensor_permute", tensor_permute<T, tile_size, sg_size>},
+    };
+
+    driver.run_all(funcs, opt,
+                   [&](func_t &func) { func(q, d_in, d_out, desc); },
+                   [&] { q.fill(d_out, T{0}, size).wait(); },
+                   [&] { sycl_acc_check(q, out, d_out); });
+
+    pool.free(d_in, q);
+    pool.free(d_out, q);
+}
+
+template<typename T>
+void test_matrix_transpose_inplace(bench::Driver &driver) {
+    using namespace cbu;
+    driver.section("in-place square transpose");
+
+    size_t batch = driver.arg("batch", 16), n = driver.arg("square", 2048);
+    size_t size = batch * n * n;
+    PermuteDesc desc = make_permute_desc({batch, n, n}, {0, 2, 1});
+    std::vector<T> in(size), out(size);
+    random_fill(in);
+    tensor_permute_ref(in.data(), out.data(), desc);
+
+    sycl::queue &q = driver.queue();
+    auto &pool = bench::usm_pool();
+    auto *d_data = pool.malloc_device<T>(size, q);
+    auto *d_copy = pool.malloc_device<T>(size, q);
+    auto reset = [&] { q.memcpy(d_data, in.data(), size * sizeof(T)).wait(); };
+
+    BenchmarkOptions opt{
+        .total_mem_bytes = 2 * size * sizeof(T),
+    };
+    driver.run("vector_copy_with_vec", [&] {
+        vector_copy_with_vec<T, 256, sg_size, 4>(q, d_data, d_copy, size);
+        q.wait();
+    }, opt);
+    driver.baseline("vector_copy_with_vec");
+
+    using func_t = std::function<void(sycl::queue &, T *, size_t, size_t)>;
+    std::vector<std::tuple<std::string, func_t> > funcs{
+        {"matrix_transpose_inplace_naive", matrix_transpose_inplace_naive<T>},
+        {"matrix_transpose_inplace_tile_slm", matrix_transpose_inplace_tile_slm<T, tile_size, sg_size>},
+    };
+
+    // every timed call transposes the data again, so the check starts from the input once more
+    for (auto &[func_name, func]: funcs) {
+        reset();
+        driver.run(func_name, [&] {
+            func(q, d_data, n, batch);
+            q.wait();
+        }, opt, [&] {
+            reset();
+            func(q, d_data, n, batch);
+            sycl_acc_check(q, out, d_data);
+        });
+    }
+
+    pool.free(d_data, q);
+    pool.free(d_copy, q);
+}
+
+
+int main(int argc, char *argv[]) {
+    using dtype = float;
+
+    bench::Driver driver{argc, argv};
+    size_t n = driver.arg("n", 32), c = driver.arg("c", 64), h = driver.arg("h", 56), w = driver.arg("w", 56);
+    test_tensor_permute<dtype>(driver, "nchw to nhwc", {n, c, h, w}, {0, 2, 3, 1});
+    test_tensor_permute<dtype>(driver, "nhwc to nchw", {n, h, w, c}, {0, 3, 1, 2});
+
+    size_t batch = driver.arg("batch", 16), m = driver.arg("m", 1024), k = driver.arg("k", 512);
+    test_tensor_permute<dtype>(driver, "batched transpose", {batch, m, k}, {0, 2, 1});
+
+    test_tensor_permute<dtype>(driver, "6-d permute", {4, 8, 16, 8, 16, 32}, {3, 0, 5, 1, 4, 2});
+
+    test_matrix_transpose_inplace<dtype>(driver);
+}
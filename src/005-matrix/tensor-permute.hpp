@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/host-parallel.hpp"
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+
+// out = permute(in, perm) for row-major tensors of up to max_permute_dims dims:
+// out dim d is in dim perm[d], e.g. NCHW -> NHWC is perm {0, 2, 3, 1}.
+//
+// The permutation is first simplified on the host: size-1 dims are dropped and out dims that stay
+// adjacent and in order in the input are merged, so NCHW -> NHWC becomes [N, HW, C] <- [N, C, HW]
+// and a batched transpose stays 3-d. When the fastest-moving dim is unchanged both sides are
+// contiguous along it and an element-wise kernel is already coalesced; otherwise the SLM tile path
+// transposes the plane of the two fastest dims (like matrix_transpose_nd_range_tile_slm) with all
+// other dims as the batch.
+
+constexpr size_t max_permute_dims = 6;
+
+struct PermuteDesc {
+    size_t dims = 0; // after simplification
+    size_t size = 1;
+    size_t shape[max_permute_dims]{}; // out shape
+    size_t in_stride[max_permute_dims]{}; // input stride of every out dim
+    size_t out_stride[max_permute_dims]{}; // row-major output stride
+
+    bool fastest_dim_changes() const { return in_stride[dims - 1] != 1; }
+};
+
+inline PermuteDesc make_permute_desc(const std::vector<size_t> &shape, const std::vector<size_t> &perm) {
+    size_t dims = shape.size();
+    if (dims == 0 || dims > max_permute_dims || perm.size() != dims) {
+        throw std::invalid_argument("permute supports 1 to " + std::to_string(max_permute_dims) + " dims");
+    }
+    std::vector<bool> seen(dims, false);
+    for (size_t p: perm) {
+        if (p >= dims || seen[p]) throw std::invalid_argument("perm is not a permutation");
+        seen[p] = true;
+    }
+
+    std::vector<size_t> stride(dims, 1);
+    for (size_t d = dims - 1; d > 0; d--) {
+        stride[d - 1] = stride[d] * shape[d];
+    }
+
+    PermuteDesc desc;
+    for (size_t d = 0; d < dims; d++) {
+        size_t s = shape[perm[d]];
+        desc.size *= s;
+        if (s == 1) continue;
+        if (desc.dims > 0 && desc.in_stride[desc.dims - 1] == stride[perm[d]] * s) {
+            // contiguous in the input as well: merge into the previous out dim
+            desc.shape[desc.dims - 1] *= s;
+            desc.in_stride[desc.dims - 1] = stride[perm[d]];
+            continue;
+        }
+        desc.shape[desc.dims] = s;
+        desc.in_stride[desc.dims] = stride[perm[d]];
+        desc.dims++;
+    }
+    if (desc.dims == 0) {
+        desc.shape[0] = 1;
+        desc.in_stride[0] = 1;
+        desc.dims = 1;
+    }
+    desc.out_stride[desc.dims - 1] = 1;
+    for (size_t d = desc.dims - 1; d > 0; d--) {
+        desc.out_stride[d - 1] = desc.out_stride[d] * desc.shape[d];
+    }
+    return desc;
+}
+
+template<typename T>
+void tensor_permute_ref(const T *in, T *out, const PermuteDesc &desc) {
+    bench::host_parallel_for(desc.size, [&](size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; idx++) {
+            size_t rest = idx, offset = 0;
+            for (size_t d = desc.dims; d-- > 0;) {
+                offset += rest % desc.shape[d] * desc.in_stride[d];
+                rest /= desc.shape[d];
+            }
+            out[idx] = in[offset];
+        }
+    });
+}
+
+// One work-item per output element: coalesced writes, gathered reads.
+template<typename T>
+void tensor_permute_naive(sycl::queue &q, T *in, T *out, const PermuteDesc &desc) {
+    bench::track(q.parallel_for({desc.size}, [=](sycl::id<1> idx) {
+        size_t rest = idx[0], offset = 0;
+        for (size_t d = desc.dims; d-- > 0;) {
+            offset += rest % desc.shape[d] * desc.in_stride[d];
+            rest /= desc.shape[d];
+        }
+        out[idx[0]] = in[offset];
+    }));
+}
+
+// Tiles the plane (r, last) where r is the out dim that is fastest in the input: a work-group reads a
+// TILE x TILE block contiguous along r, and writes it transposed, contiguous along the last out dim.
+// The remaining dims are flattened into dimension 0 of the nd_range.
+template<typename T, size_t TILE, size_t SG_SIZE>
+void tensor_permute_tile_slm(sycl::queue &q, T *in, T *out, const PermuteDesc &desc) {
+    constexpr size_t max_batch_dims = max_permute_dims - 2;
+    size_t last = desc.dims - 1;
+    size_t r = std::find(desc.in_stride, desc.in_stride + desc.dims, size_t{1}) - desc.in_stride;
+    if (r >= last) throw std::invalid_argument("tensor_permute_tile_slm needs the fastest dim to change");
+
+    size_t batch_dims = 0, batch = 1;
+    size_t b_shape[max_batch_dims]{}, b_in_stride[max_batch_dims]{}, b_out_stride[max_batch_dims]{};
+    for (size_t d = 0; d < last; d++) {
+        if (d == r) continue;
+        b_shape[batch_dims] = desc.shape[d];
+        b_in_stride[batch_dims] = desc.in_stride[d];
+        b_out_stride[batch_dims] = desc.out_stride[d];
+        batch *= desc.shape[d];
+        batch_dims++;
+    }
+    size_t rows = desc.shape[last], cols = desc.shape[r]; // the plane as seen by the input
+    size_t row_stride = desc.in_stride[last], col_stride_out = desc.out_stride[r];
+
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<T, 2> slm{{TILE, TILE + 1}, h}; // avoid bank conflict
+        h.parallel_for(
+            sycl::nd_range<3>{{batch, round_up(rows, TILE), round_up(cols, TILE)}, {1, TILE, TILE}},
+            [=](sycl::nd_item<3> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t rest = item.get_group(0), in_base = 0, out_base = 0;
+                for (size_t d = batch_dims; d-- > 0;) {
+                    size_t c = rest % b_shape[d];
+                    rest /= b_shape[d];
+                    in_base += c * b_in_stride[d];
+                    out_base += c * b_out_stride[d];
+                }
+
+                size_t l_i = item.get_local_id(1);
+                size_t l_j = item.get_local_id(2);
+                size_t i = item.get_global_id(1);
+                size_t j = item.get_global_id(2);
+                if (i < rows && j < cols) {
+                    slm[l_i][l_j] = in[in_base + i * row_stride + j];
+                }
+                item.barrier(sycl::access::fence_space::local_space);
+
+                // Diagonal block mapping
+                i = item.get_group(2) * TILE + l_i;
+                j = item.get_group(1) * TILE + l_j;
+                if (i < cols && j < rows) {
+                    out[out_base + i * col_stride_out + j] = slm[l_j][l_i];
+                }
+            });
+    }));
+}
+
+template<typename T, size_t TILE, size_t SG_SIZE>
+void tensor_permute(sycl::queue &q, T *in, T *out, const PermuteDesc &desc) {
+    if (desc.fastest_dim_changes()) {
+        tensor_permute_tile_slm<T, TILE, SG_SIZE>(q, in, out, desc);
+    } else {
+        tensor_permute_naive(q, in, out, desc);
+    }
+}
+
+// In-place transpose of batch square [n,n] row-major matrices. A square transpose permutes elements in
+// cycles of length 2, (i,j) <-> (j,i), so following the cycles means swapping mirrored pairs.
+
+template<typename T>
+void matrix_transpose_inplace_naive(sycl::queue &q, T *data, size_t n, size_t batch) {
+    bench::track(q.parallel_for({batch, n, n}, [=](sycl::id<3> idx) {
+        size_t i = idx[1];
+        size_t j = idx[2];
+        if (j <= i) return;
+        T *mat = data + idx[0] * n * n;
+        std::swap(mat[i * n + j], mat[j * n + i]);
+    }));
+}
+
+// The same cycles at tile granularity: a work-group owns the tile pair (bi,bj), (bj,bi) with bi <= bj,
+// loads both into SLM and writes each transposed into the other's place. Every access is contiguous
+// along a row. Work-groups below the diagonal exit immediately.
+template<typename T, size_t TILE, size_t SG_SIZE>
+void matrix_transpose_inplace_tile_slm(sycl::queue &q, T *data, size_t n, size_t batch) {
+    size_t tiles = ceil_div(n, TILE);
+    bench::track(q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<T, 2> tile{{TILE, TILE + 1}, h};
+        sycl::local_accessor<T, 2> mirror{{TILE, TILE + 1}, h};
+        h.parallel_for(
+            sycl::nd_range<3>{{batch, tiles * TILE, tiles * TILE}, {1, TILE, TILE}},
+            [=](sycl::nd_item<3> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+                size_t bi = item.get_group(1);
+                size_t bj = item.get_group(2);
+                if (bi > bj) return;
+
+                T *mat = data + item.get_group(0) * n * n;
+                size_t l_i = item.get_local_id(1);
+                size_t l_j = item.get_local_id(2);
+                size_t i = bi * TILE + l_i, j = bj * TILE + l_j;
+                size_t m_i = bj * TILE + l_i, m_j = bi * TILE + l_j;
+                if (i < n && j < n) tile[l_i][l_j] = mat[i * n + j];
+                if (m_i < n && m_j < n) mirror[l_i][l_j] = mat[m_i * n + m_j];
+                item.barrier(sycl::access::fence_space::local_space);
+
+                if (i < n && j < n) mat[i * n + j] = mirror[l_j][l_i];
+                if (bi != bj && m_i < n && m_j < n) mat[m_i * n + m_j] = tile[l_j][l_i];
+            });
+    }));
+}
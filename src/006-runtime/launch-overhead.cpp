@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/bench-driver.hpp"
+#include "common/usm-pool.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Fixed costs of the runtime, measured with kernels that do nothing: launch, synchronization,
+// queue ordering and dependency tracking. Every benchmark loop pays these on top of the kernel, so
+// they are the floor to subtract before sizing batches. Times are per iteration of each variant;
+// the "x batch" variants submit --batch commands and wait once, so divide by the batch.
+
+void bench_launch(bench::Driver &driver, sycl::queue &q, const std::string &queue_name, size_t batch) {
+    driver.section("launch, " + queue_name + " queue");
+    cbu::BenchmarkOptions opt{};
+
+    driver.run("single_task + event.wait", [&] {
+        q.single_task([=] {}).wait();
+    }, opt);
+    driver.baseline("single_task + event.wait");
+
+    driver.run("single_task + queue.wait", [&] {
+        q.single_task([=] {});
+        q.wait();
+    }, opt);
+
+    for (size_t range: {size_t{1}, size_t{1024}, size_t{64 * 1024}, size_t{1024 * 1024}}) {
+        driver.run("parallel_for " + std::to_string(range) + " + event.wait", [&] {
+            q.parallel_for(range, [=](sycl::id<1>) {}).wait();
+        }, opt);
+    }
+
+    driver.run("nd_range 1048576/256 + event.wait", [&] {
+        q.parallel_for(sycl::nd_range<1>{1024 * 1024, 256}, [=](sycl::nd_item<1>) {}).wait();
+    }, opt);
+
+    driver.run("single_task x " + std::to_string(batch) + " + queue.wait", [&] {
+        for (size_t i = 0; i < batch; i++) {
+            q.single_task([=] {});
+        }
+        q.wait();
+    }, opt);
+}
+
+void bench_sync(bench::Driver &driver, sycl::queue &q, size_t batch) {
+    driver.section("synchronization, in-order queue");
+    cbu::BenchmarkOptions opt{};
+
+    // nothing in flight: the pure cost of asking
+    q.wait();
+    driver.run("queue.wait, idle queue", [&] { q.wait(); }, opt);
+
+    sycl::event done = q.single_task([=] {});
+    done.wait();
+    driver.run("event.wait, completed event", [&] { done.wait(); }, opt);
+
+    driver.run("event status poll, completed event", [&] {
+        while (done.get_info<sycl::info::event::command_execution_status>()
+               != sycl::info::event_command_status::complete) {}
+    }, opt);
+
+    driver.run("single_task + event.wait_and_throw", [&] {
+        q.single_task([=] {}).wait_and_throw();
+    }, opt);
+    driver.baseline("single_task + event.wait_and_throw");
+
+    driver.run("single_task x " + std::to_string(batch) + " + event.wait on each", [&] {
+        for (size_t i = 0; i < batch; i++) {
+            q.single_task([=] {}).wait();
+        }
+    }, opt);
+
+    driver.run("host_task + event.wait", [&] {
+        q.submit([&](sycl::handler &h) {
+            h.host_task([] {});
+        }).wait();
+    }, opt);
+
+    driver.run("barrier + event.wait", [&] {
+        q.ext_oneapi_submit_barrier().wait();
+    }, opt);
+
+    int host_value = 0;
+    int *device_value = bench::usm_pool().malloc_device<int>(1, q);
+    q.memset(device_value, 0, sizeof(int)).wait();
+    driver.run("memcpy 4 bytes device to host + event.wait", [&] {
+        q.memcpy(&host_value, device_value, sizeof(int)).wait();
+    }, opt);
+    bench::usm_pool().free(device_value, q);
+}
+
+void bench_dependencies(bench::Driver &driver, sycl::queue &ooo_q, size_t dep_num) {
+    driver.section("dependencies, out-of-order queue");
+    cbu::BenchmarkOptions opt{};
+
+    // Completed events, so only the dependency bookkeeping is measured, not waiting for work.
+    std::vector<sycl::event> deps;
+    for (size_t i = 0; i < dep_num; i++) {
+        deps.push_back(ooo_q.single_task([=] {}));
+    }
+    sycl::event::wait(deps);
+
+    driver.run("single_task, 0 deps", [&] {
+        ooo_q.single_task([=] {}).wait();
+    }, opt);
+    driver.baseline("single_task, 0 deps");
+
+    driver.run("single_task, 1 dep", [&] {
+        ooo_q.single_task(deps[0], [=] {}).wait();
+    }, opt);
+
+    driver.run("single_task, " + std::to_string(dep_num) + " deps", [&] {
+        ooo_q.single_task(deps, [=] {}).wait();
+    }, opt);
+
+    // Pending dependencies: a chain and a fan-in of dep_num kernels submitted in the same iteration.
+    driver.run("chain of " + std::to_string(dep_num) + " single_task", [&] {
+        sycl::event prev = ooo_q.single_task([=] {});
+        for (size_t i = 1; i < dep_num; i++) {
+            prev = ooo_q.single_task(prev, [=] {});
+        }
+        prev.wait();
+    }, opt);
+
+    driver.run("fan-in of " + std::to_string(dep_num) + " single_task", [&] {
+        std::vector<sycl::event> pending;
+        for (size_t i = 0; i < dep_num; i++) {
+            pending.push_back(ooo_q.single_task([=] {}));
+        }
+        ooo_q.single_task(pending, [=] {}).wait();
+    }, opt);
+}
+
+
+int main(int argc, char *argv[]) {
+    bench::Driver driver{argc, argv};
+    size_t batch = driver.arg("batch", 100);
+    size_t deps = std::max<size_t>(driver.arg("deps", 16), 1);
+
+    sycl::queue &q = driver.queue();
+    sycl::queue ooo_q{q.get_context(), q.get_device()};
+
+    bench_launch(driver, q, "in-order", batch);
+    bench_launch(driver, ooo_q, "out-of-order", batch);
+    bench_sync(driver, q, batch);
+    bench_dependencies(driver, ooo_q, deps);
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+// Autotuner for the WG_SIZE / SG_SIZE / WI_SIZE template parameters of the kernels.
+//
+// A grid of configurations is instantiated at compile time with make_grid(). At runtime the tuner
+// benchmarks only the configurations the device supports, stores the winner per
+// (device name, kernel, size class) in a cache file and dispatches to it on later calls.
+//
+// The cache file defaults to ./learn-sycl-tuning.cache and can be moved with LEARN_SYCL_TUNING_CACHE.
+
+namespace bench {
+
+template<size_t... V>
+struct values {
+};
+
+struct TuneConfig {
+    size_t wg_size;
+    size_t sg_size;
+    size_t wi_size;
+    size_t wg_items; // work-items per work-group, WG_SIZE^dims for multi-dimensional kernels
+
+    std::string str() const {
+        return "wg=" + std::to_string(wg_size) + ",sg=" + std::to_string(sg_size) + ",wi=" + std::to_string(wi_size);
+    }
+};
+
+template<typename Func>
+struct Candidate {
+    TuneConfig config;
+    Func func;
+};
+
+namespace detail {
+    template<typename Func, size_t DIMS, size_t WG, size_t SG, size_t... WI, typename Make>
+    void add_wi(std::vector<Candidate<Func> > &out, Make &make) {
+        size_t items = 1;
+        for (size_t d = 0; d < DIMS; d++) items *= WG;
+        (out.push_back({{WG, SG, WI, items}, make.template operator()<WG, SG, WI>()}), ...);
+    }
+
+    template<typename Func, size_t DIMS, size_t WG, size_t... SG, size_t... WI, typename Make>
+    void add_sg(std::vector<Candidate<Func> > &out, values<SG...>, values<WI...>, Make &make) {
+        (add_wi<Func, DIMS, WG, SG, WI...>(out, make), ...);
+    }
+}
+
+// Instantiate make.template operator()<WG, SG, WI>() for every point of the WG x SG x WI grid.
+// Kernels without a WI_SIZE parameter pass values<1>{} and ignore it.
+template<typename Func, size_t DIMS = 1, size_t... WG, typename SGs, typename WIs, typename Make>
+std::vector<Candidate<Func> > make_grid(values<WG...>, SGs sgs, WIs wis, Make make) {
+    std::vector<Candidate<Func> > out;
+    (detail::add_sg<Func, DIMS, WG>(out, sgs, wis, make), ...);
+    return out;
+}
+
+inline bool is_supported(const sycl::device &device, const TuneConfig &config) {
+    auto sg_sizes = device.get_info<sycl::info::device::sub_group_sizes>();
+    auto max_wg = device.get_info<sycl::info::device::max_work_group_size>();
+    bool sg_ok = std::find(sg_sizes.begin(), sg_sizes.end(), config.sg_size) != sg_sizes.end();
+    return sg_ok && config.wg_items <= max_wg && config.sg_size <= config.wg_items;
+}
+
+// Problem sizes are bucketed by power of two so one tuning run covers nearby sizes.
+inline size_t size_class(size_t problem_size) {
+    size_t cls = 0;
+    while (problem_size >>= 1) cls++;
+    return cls;
+}
+
+class Tuner {
+public:
+    explicit Tuner(bool retune = false, double secs_per_config = 0.2)
+        : retune(retune), secs_per_config(secs_per_config) {
+        const char *env = std::getenv("LEARN_SYCL_TUNING_CACHE");
+        path = env ? env : "learn-sycl-tuning.cache";
+        load();
+    }
+
+    // Return the fastest supported candidate, benchmarking the grid on a cache miss.
+    // launch(func) must run one instance of the kernel to completion.
+    template<typename Func, typename Launch>
+    Func &select(sycl::queue &q, const std::string &kernel, size_t problem_size,
+                 std::vector<Candidate<Func> > &candidates, Launch &&launch) {
+        return candidates[select_index(q, kernel, problem_size, candidates, launch)].func;
+    }
+
+    // Wrap a grid into a single callable with the kernel signature. The first argument must be the
+    // sycl::queue; problem_size selects the size class used as part of the cache key.
+    template<typename R, typename... Args>
+    std::function<R(Args...)> dispatch(const std::string &kernel,
+                                       std::vector<Candidate<std::function<R(Args...)> > > candidates,
+                                       size_t problem_size) {
+        size_t chosen = candidates.size();
+        return [this, kernel, candidates = std::move(candidates), problem_size, chosen](Args... args) mutable -> R {
+            if (chosen == candidates.size()) {
+                sycl::queue &q = std::get<0>(std::forward_as_tuple(args...));
+                chosen = select_index(q, kernel, problem_size, candidates, [&](auto &f) {
+                    f(args...);
+                    q.wait();
+                });
+            }
+            return candidates[chosen].func(args...);
+        };
+    }
+
+private:
+    struct Entry {
+        std::string config;
+        double ms;
+    };
+
+    std::string path;
+    bool retune;
+    double secs_per_config;
+    std::map<std::string, Entry> cache;
+    std::set<std::string> retuned;
+
+    template<typename Func, typename Launch>
+    size_t select_index(sycl::queue &q, const std::string &kernel, size_t problem_size,
+                        std::vector<Candidate<Func> > &candidates, Launch &&launch) {
+        auto device = q.get_device();
+        std::string key = device.get_info<sycl::info::device::name>() + "\t" + kernel
+                          + "\t" + std::to_string(size_class(problem_size));
+
+        auto it = cache.find(key);
+        if (it != cache.end() && (!retune || retuned.count(key))) {
+            for (size_t i = 0; i < candidates.size(); i++) {
+                if (candidates[i].config.str() == it->second.config) return i;
+            }
+        }
+
+        size_t best = candidates.size();
+        double best_ms = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (!is_supported(device, candidates[i].config)) continue;
+            try {
+                double ms = measure(candidates[i].func, launch);
+                if (ms < best_ms) {
+                    best_ms = ms;
+                    best = i;
+                }
+            } catch (const std::exception &) {
+                // rejected by this problem size or device, e.g. divisibility or SLM size
+            }
+        }
+        if (best == candidates.size()) {
+            throw std::runtime_error("No supported tuning configuration for " + kernel);
+        }
+
+        std::cerr << "tuned " << kernel << " (size class " << size_class(problem_size) << "): "
+                << candidates[best].config.str() << ", " << best_ms << " ms\n";
+        cache[key] = {candidates[best].config.str(), best_ms};
+        retuned.insert(key);
+        save();
+        return best;
+    }
+
+    template<typename Func, typename Launch>
+    double measure(Func &func, Launch &launch) const {
+        using clock = std::chrono::steady_clock;
+        launch(func); // warm up and JIT
+
+        size_t iterations = 0;
+        auto begin = clock::now();
+        double elapsed = 0;
+        do {
+            launch(func);
+            iterations++;
+            elapsed = std::chrono::duration<double>(clock::now() - begin).count();
+        } while (elapsed < secs_per_config || iterations < 3);
+        return elapsed * 1e3 / iterations;
+    }
+
+    // One entry per line: device \t kernel \t size class \t config \t ms
+    void load() {
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            std::vector<std::string> fields;
+            std::stringstream ss(line);
+            for (std::string field; std::getline(ss, field, '\t');) fields.push_back(field);
+            if (fields.size() != 5) continue;
+            cache[fields[0] + "\t" + fields[1] + "\t" + fields[2]] = {fields[3], std::stod(fields[4])};
+        }
+    }
+
+    void save() const {
+        std::ofstream file(path);
+        if (!file) {
+            std::cerr << "cannot write tuning cache: " << path << "\n";
+            return;
+        }
+        for (const auto &[key, entry]: cache) {
+            file << key << "\t" << entry.config << "\t" << entry.ms << "\n";
+        }
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,590 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/graph.hpp"
+#include "common/profiling.hpp"
+#include "common/roofline.hpp"
+#include "common/tensor-file.hpp"
+#include "common/usm-pool.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Shared benchmark driver for the kernel families under src/.
+//
+// Command line flags (all optional):
+//   --device=<gpu|cpu|acc|default|index|name>  device to run on, index/name as listed by --list-devices
+//   --secs=<seconds>                           time budget per variant (default 10)
+//   --filter=<a,b,...>                         only run variants whose name contains one of the substrings
+//   --format=<text|json|csv>                   result format, json/csv are emitted when the driver exits
+//   --output=<path>                            write json/csv results to a file instead of stdout
+//   --graph                                    also run every run_all variant as a recorded graph replay
+//   --profiling=0                              no enable_profiling on the queue, wall-clock times only
+//   --roofline                                 measure the device peaks and place every variant on the roofline
+//   --peak_gbps=<x> --peak_gflops=<x>          use these peaks instead of measuring them, implies --roofline
+//   --<key>=<value>                            problem sizes queried by the benchmark, e.g. --size=64M --m=1000
+//   --<flag>                                   benchmark specific switches, same as --<flag>=1
+//   --<input>=<file>                           read an input from a tensor file instead of random data, see input()
+//   --list-devices                             print all devices with their index and exit
+
+namespace bench {
+
+enum class output_format { text, json, csv };
+
+struct Result {
+    std::string family;
+    std::string section;
+    std::string variant;
+    std::string device;
+    std::string shape;
+    std::string status;
+    size_t iterations = 0;
+    double avg_ms = 0;
+    double min_ms = 0;
+    double gbps = 0;
+    double gflops = 0;
+    double speedup = 0; // baseline avg_ms / avg_ms, 0 when the section has no baseline
+    double device_ms = 0; // avg device time of the tracked commands (common/profiling.hpp), 0 when unknown
+    double host_ms = 0; // avg_ms - device_ms: submission, runtime and synchronization overhead
+    double intensity = 0; // flop/byte, with --roofline
+    double roof_pct = 0; // percent of the attainable roof at this intensity, 0 without --roofline
+    std::string bound; // "memory" or "compute", empty without --roofline
+};
+
+inline size_t parse_size(const std::string &text) {
+    size_t pos = 0;
+    size_t value = std::stoull(text, &pos);
+    std::string suffix = text.substr(pos);
+    if (suffix.empty()) return value;
+    switch (std::toupper(suffix[0])) {
+        case 'K': return value * 1024;
+        case 'M': return value * 1024 * 1024;
+        case 'G': return value * 1024 * 1024 * 1024;
+        default: throw std::invalid_argument("Unknown size suffix: " + text);
+    }
+}
+
+inline std::string device_type_name(const sycl::device &device) {
+    switch (device.get_info<sycl::info::device::device_type>()) {
+        case sycl::info::device_type::cpu: return "cpu";
+        case sycl::info::device_type::gpu: return "gpu";
+        case sycl::info::device_type::accelerator: return "acc";
+        default: return "other";
+    }
+}
+
+inline void list_devices(std::ostream &os) {
+    auto devices = sycl::device::get_devices();
+    for (size_t i = 0; i < devices.size(); i++) {
+        os << "[" << i << "] " << device_type_name(devices[i]) << " : "
+                << devices[i].get_info<sycl::info::device::name>() << "\n";
+    }
+}
+
+inline sycl::device select_device(const std::string &spec) {
+    if (spec == "gpu") return sycl::device{cbu::gpu_selector_by_cu};
+    if (spec == "cpu") return sycl::device{sycl::cpu_selector_v};
+    if (spec == "acc") return sycl::device{sycl::accelerator_selector_v};
+    if (spec == "default") return sycl::device{sycl::default_selector_v};
+
+    auto devices = sycl::device::get_devices();
+    if (!spec.empty() && std::all_of(spec.begin(), spec.end(), ::isdigit)) {
+        size_t index = std::stoull(spec);
+        if (index >= devices.size()) {
+            throw std::invalid_argument("Device index out of range: " + spec);
+        }
+        return devices[index];
+    }
+    for (const auto &device: devices) {
+        if (device.get_info<sycl::info::device::name>().find(spec) != std::string::npos) {
+            return device;
+        }
+    }
+    throw std::invalid_argument("No device matches: " + spec);
+}
+
+class Driver {
+public:
+    Driver(int argc, char *argv[]) {
+        std::string program = argc > 0 ? argv[0] : "benchmark";
+        family = program.substr(program.find_last_of("/\\") + 1);
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_help();
+                std::exit(0);
+            }
+            if (arg == "--list-devices") {
+                list_devices(std::cout);
+                std::exit(0);
+            }
+            if (arg.rfind("--", 0) != 0) {
+                throw std::invalid_argument("Unexpected argument: " + arg);
+            }
+
+            std::string key, value;
+            size_t eq = arg.find('=');
+            if (eq != std::string::npos) {
+                key = arg.substr(2, eq - 2);
+                value = arg.substr(eq + 1);
+            } else if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                key = arg.substr(2);
+                value = argv[++i];
+            } else {
+                key = arg.substr(2); // bare flag, e.g. --graph
+                value = "1";
+            }
+            args[key] = value;
+        }
+
+        device_spec = take("device", "gpu");
+        secs = std::stod(take("secs", "10"));
+        std::string format_name = take("format", "text");
+        if (format_name == "json") format = output_format::json;
+        else if (format_name == "csv") format = output_format::csv;
+        else if (format_name != "text") throw std::invalid_argument("Unknown format: " + format_name);
+        output_path = take("output", "");
+        graph_replay = flag("graph");
+        args.erase("graph");
+        profiling = take("profiling", "1") != "0";
+        peaks.gbps = std::stod(take("peak_gbps", "0"));
+        peaks.gflops = std::stod(take("peak_gflops", "0"));
+        roofline = flag("roofline") || peaks.gbps > 0 || peaks.gflops > 0;
+        args.erase("roofline");
+
+        std::stringstream ss(take("filter", ""));
+        for (std::string item; std::getline(ss, item, ',');) {
+            if (!item.empty()) filters.push_back(item);
+        }
+    }
+
+    Driver(const Driver &) = delete;
+    Driver &operator=(const Driver &) = delete;
+
+    ~Driver() {
+        PoolStats pool = usm_pool().stats();
+        if (pool.hits + pool.misses > 0) {
+            usm_pool().print_stats(log());
+        }
+        try {
+            emit();
+        } catch (const std::exception &e) {
+            std::cerr << "failed to write results: " << e.what() << "\n";
+        }
+    }
+
+    // Human readable progress goes to stderr when machine readable output owns stdout.
+    std::ostream &log() {
+        return format != output_format::text && output_path.empty() ? std::cerr : std::cout;
+    }
+
+    // Lazily created so that host-only benchmarks never touch the SYCL runtime.
+    sycl::queue &queue() {
+        if (!q) {
+            sycl::property_list props{sycl::property::queue::in_order()};
+            if (profiling) {
+                props = {sycl::property::queue::in_order(), sycl::property::queue::enable_profiling()};
+            }
+            q = std::make_unique<sycl::queue>(select_device(device_spec), props);
+            device_name = q->get_device().get_info<sycl::info::device::name>();
+            log() << "Running on: " << device_name << "\n";
+        }
+        return *q;
+    }
+
+    // Query a problem size, e.g. driver.arg("m", 2048). Accepts K/M/G binary suffixes.
+    size_t arg(const std::string &key, size_t default_value) {
+        auto it = args.find(key);
+        size_t value = it == args.end() ? default_value : parse_size(it->second);
+        shape[key] = value;
+        return value;
+    }
+
+    // Query a string option, e.g. driver.option("a", "") for an input file.
+    std::string option(const std::string &key, const std::string &default_value) const {
+        auto it = args.find(key);
+        return it == args.end() ? default_value : it->second;
+    }
+
+    // Fill a rows x cols input (a vector: cols = 1) from the tensor file given as --<name>=<file>, read through
+    // an mmap (common/tensor-file.hpp), or with random values when there is none. The file must hold that shape
+    // and element type; its layout and ld may differ from the requested layout, the copy converts them.
+    template<typename T>
+    void input(const std::string &name, std::vector<T> &vec, size_t rows, size_t cols,
+               cbu::matrix_layout layout = cbu::matrix_layout::row_major) {
+        std::string path = option(name, "");
+        if (path.empty()) {
+            cbu::random_fill(vec);
+            return;
+        }
+
+        MappedTensor mapped{path};
+        if (mapped.rows() != rows || mapped.cols() != cols || vec.size() != rows * cols) {
+            throw std::runtime_error("--" + name + "=" + path + " holds " + std::to_string(mapped.rows()) + " x "
+                                     + std::to_string(mapped.cols()) + ", the benchmark needs "
+                                     + std::to_string(rows) + " x " + std::to_string(cols));
+        }
+        const T *src = mapped.data<T>();
+        bool src_col = mapped.layout() == cbu::matrix_layout::col_major && cols != 1;
+        bool dst_col = layout == cbu::matrix_layout::col_major && cols != 1;
+        if (src_col == dst_col && mapped.packed()) {
+            std::copy_n(src, vec.size(), vec.begin());
+        } else {
+            size_t ld = mapped.ld(), dst_ld = dst_col ? rows : cols;
+            for (size_t i = 0; i < rows; i++) {
+                for (size_t j = 0; j < cols; j++) {
+                    T x = src_col ? src[j * ld + i] : src[i * ld + j];
+                    (dst_col ? vec[j * dst_ld + i] : vec[i * dst_ld + j]) = x;
+                }
+            }
+        }
+        log() << "\t" << name << " from " << path << "\n";
+    }
+
+    bool flag(const std::string &key) const {
+        auto it = args.find(key);
+        return it != args.end() && it->second != "0" && it->second != "false";
+    }
+
+    double time_budget() const { return secs; }
+
+    // Device peaks for the roofline, measured on first use unless given on the command line.
+    const Roof &roof() {
+        if (!roof_measured) {
+            sycl::queue &q = queue();
+            if (peaks.gbps <= 0) peaks.gbps = measure_peak_gbps(q);
+            if (peaks.gflops <= 0) peaks.gflops = measure_peak_gflops(q);
+            roof_measured = true;
+            log() << "Roofline: " << std::fixed << std::setprecision(1) << peaks.gbps << " GB/s, "
+                    << peaks.gflops << " GFLOP/s FP32, ridge at " << std::setprecision(2) << peaks.ridge()
+                    << " flop/byte" << std::defaultfloat << "\n";
+        }
+        return peaks;
+    }
+
+    // Same as --graph: run_all follows every eager variant with its recorded replay.
+    void set_graph_replay(bool on) { graph_replay = on; }
+
+    bool enabled(const std::string &variant) const {
+        if (filters.empty()) return true;
+        return std::any_of(filters.begin(), filters.end(), [&](const std::string &f) {
+            return variant.find(f) != std::string::npos;
+        });
+    }
+
+    void section(const std::string &name) {
+        current_section = name;
+        baseline_variant.clear();
+        baseline_section.clear();
+        log() << "-------------- " << name << " --------------\n";
+    }
+
+    // Report the variants that run after this one in the current section as a speedup over it.
+    void baseline(const std::string &variant) {
+        baseline_variant = variant;
+        baseline_section.clear();
+    }
+
+    // Same, with a variant that ran in an earlier section, e.g. one shared baseline for several sections.
+    // Call it after section().
+    void baseline(const std::string &variant, const std::string &section) {
+        baseline_variant = variant;
+        baseline_section = section;
+    }
+
+    // Benchmark one host-synchronous callable and validate its output with check().
+    template<typename Func, typename Check>
+    void run(const std::string &name, Func &&func, const cbu::BenchmarkOptions &opt, Check &&check) {
+        if (!enabled(name)) return;
+        record(name, device_name.empty() ? "host" : device_name, func, opt, check);
+    }
+
+    template<typename Func>
+    void run(const std::string &name, Func &&func, const cbu::BenchmarkOptions &opt) {
+        run(name, std::forward<Func>(func), opt, [] {});
+    }
+
+    // References feed the accuracy checks, so they always run once even when filtered out. on_device marks a
+    // reference that runs as a kernel on the driver's queue: it is labelled with the device and placed on the
+    // roofline like any other device variant.
+    template<typename Func>
+    void run_ref(const std::string &name, Func &&func, const cbu::BenchmarkOptions &opt, bool on_device) {
+        if (enabled(name)) {
+            record(name, on_device && !device_name.empty() ? device_name : "host", func, opt, [] {});
+        } else {
+            func();
+        }
+    }
+
+    template<typename Func>
+    void run_ref(const std::string &name, Func &&func, const cbu::BenchmarkOptions &opt) {
+        run_ref(name, std::forward<Func>(func), opt, false);
+    }
+
+    // Replaces the per-file `for (auto [func_name, func] : funcs)` loop:
+    // reset() runs before each variant, launch(func) submits it, check() validates the output.
+    template<typename Funcs, typename Launch, typename Reset, typename Check>
+    void run_all(Funcs &funcs, const cbu::BenchmarkOptions &opt, Launch &&launch, Reset &&reset, Check &&check) {
+        for (auto &[func_name, func]: funcs) {
+            if (!enabled(func_name)) continue;
+            reset();
+            run(func_name, [&] {
+                launch(func);
+                queue().wait();
+            }, opt, check);
+            if (graph_replay) {
+                run_replayed(func_name, [&] { launch(func); }, opt, reset, check);
+            }
+        }
+    }
+
+    // Record launch() once (common/graph.hpp) and time its replays, reported as a speedup over the
+    // eager variant of the same name.
+    template<typename Launch, typename Reset, typename Check>
+    void run_replayed(const std::string &name, Launch &&launch, const cbu::BenchmarkOptions &opt,
+                      Reset &&reset, Check &&check) {
+        reset();
+        launch(); // JIT, tuning and pool warm-up stay out of the recording
+        queue().wait();
+        Recording recording{queue(), [&](sycl::queue &) { launch(); }};
+
+        std::string section_baseline = std::exchange(baseline_variant, name);
+        std::string section_baseline_section = std::exchange(baseline_section, "");
+        run(name + (recording.recorded() ? " (graph)" : " (graph unavailable, eager)"), [&] {
+            recording.replay();
+            queue().wait();
+        }, opt, check);
+        baseline_variant = section_baseline;
+        baseline_section = section_baseline_section;
+    }
+
+private:
+    std::map<std::string, std::string> args;
+    std::string family;
+    std::string device_spec;
+    std::string device_name;
+    std::string current_section;
+    std::string baseline_variant;
+    std::string baseline_section; // empty: the current section
+    std::map<std::string, size_t> shape;
+    std::string output_path;
+    std::vector<std::string> filters;
+    output_format format = output_format::text;
+    double secs = 10;
+    bool graph_replay = false;
+    bool profiling = true;
+    bool roofline = false;
+    bool roof_measured = false;
+    Roof peaks;
+    std::unique_ptr<sycl::queue> q;
+    std::vector<Result> results;
+
+    template<typename Func, typename Check>
+    void record(const std::string &name, const std::string &device, Func &func,
+                const cbu::BenchmarkOptions &opt, Check &&check) {
+        Result result{
+            .family = family,
+            .section = current_section,
+            .variant = name,
+            .device = device,
+            .shape = shape_string(),
+        };
+
+        bool on_roof = roofline && device != "host" && (opt.total_mem_bytes || opt.total_flop);
+        if (on_roof) roof(); // peaks first, so their log does not split the variant's
+
+        log() << "\n" << name << ":\n";
+        try {
+            measure(func, opt, result);
+            check();
+            result.status = "ok";
+            if (!baseline_variant.empty() && name != baseline_variant) {
+                auto base = std::find_if(results.rbegin(), results.rend(), [&](const Result &r) {
+                    const std::string &section = baseline_section.empty() ? current_section : baseline_section;
+                    return r.section == section && r.variant == baseline_variant && r.status == "ok";
+                });
+                if (base != results.rend()) result.speedup = base->avg_ms / result.avg_ms;
+            }
+            log() << "\titerations: " << result.iterations
+                    << ", avg: " << std::fixed << std::setprecision(3) << result.avg_ms << " ms"
+                    << ", min: " << result.min_ms << " ms";
+            if (opt.total_mem_bytes) log() << ", " << std::setprecision(2) << result.gbps << " GB/s";
+            if (opt.total_flop) log() << ", " << std::setprecision(2) << result.gflops << " GFLOP/s";
+            if (result.speedup) log() << ", " << std::setprecision(2) << result.speedup << "x vs " << baseline_variant;
+            if (result.device_ms) {
+                log() << "\n\tdevice: " << std::setprecision(3) << result.device_ms << " ms"
+                        << ", host overhead: " << result.host_ms << " ms"
+                        << " (" << std::setprecision(2) << result.host_ms / result.device_ms << "x device)";
+            }
+            if (on_roof) {
+                // against the device time when there is one, the roof is a device limit
+                double scale = result.device_ms ? result.avg_ms / result.device_ms : 1.0;
+                RooflinePoint p = classify(peaks, opt.total_mem_bytes, opt.total_flop,
+                                           result.gbps * scale, result.gflops * scale);
+                result.intensity = p.intensity;
+                result.roof_pct = p.roof_pct;
+                result.bound = p.compute_bound ? "compute" : "memory";
+                log() << "\n\troofline: " << std::setprecision(2) << p.intensity << " flop/byte, "
+                        << std::setprecision(1) << p.roof_pct << "% of roof, " << result.bound << " bound";
+            }
+            log() << std::defaultfloat << "\n";
+        } catch (const std::exception &e) {
+            result.status = std::string("error: ") + e.what();
+            log() << "\tskipped: " << e.what() << "\n";
+        }
+        results.push_back(result);
+    }
+
+    std::string take(const std::string &key, const std::string &default_value) {
+        auto it = args.find(key);
+        if (it == args.end()) return default_value;
+        std::string value = it->second;
+        args.erase(it);
+        return value;
+    }
+
+    template<typename Func>
+    void measure(Func &func, const cbu::BenchmarkOptions &opt, Result &result) {
+        using clock = std::chrono::steady_clock;
+        func(); // warm up, also triggers JIT compilation
+
+        double total_ms = 0;
+        double min_ms = std::numeric_limits<double>::max();
+        double device_total_ms = 0;
+        size_t iterations = 0, device_iterations = 0;
+        auto begin = clock::now();
+        do {
+            event_log().start();
+            auto start = clock::now();
+            func();
+            auto end = clock::now();
+            double device_ms = event_log().stop_ms(); // outside the timed region
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            total_ms += ms;
+            min_ms = std::min(min_ms, ms);
+            iterations++;
+            if (device_ms >= 0) {
+                device_total_ms += device_ms;
+                device_iterations++;
+            }
+        } while (std::chrono::duration<double>(clock::now() - begin).count() < secs);
+
+        result.iterations = iterations;
+        result.avg_ms = total_ms / iterations;
+        result.min_ms = min_ms;
+        result.gbps = static_cast<double>(opt.total_mem_bytes) / (result.avg_ms * 1e6);
+        result.gflops = static_cast<double>(opt.total_flop) / (result.avg_ms * 1e6);
+        // only when every iteration had device timestamps, a partial sum would understate the device
+        if (device_iterations == iterations) {
+            result.device_ms = device_total_ms / iterations;
+            result.host_ms = std::max(result.avg_ms - result.device_ms, 0.0);
+        }
+    }
+
+    std::string shape_string() const {
+        std::string out;
+        for (const auto &[key, value]: shape) {
+            out += (out.empty() ? "" : " ") + key + "=" + std::to_string(value);
+        }
+        return out;
+    }
+
+    static std::string json_escape(const std::string &s) {
+        std::string out;
+        for (char c: s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    static std::string csv_escape(const std::string &s) {
+        if (s.find_first_of(",\"") == std::string::npos) return s;
+        std::string out = "\"";
+        for (char c: s) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    void emit() {
+        if (format == output_format::text) return;
+
+        std::ofstream file;
+        if (!output_path.empty()) {
+            file.open(output_path);
+            if (!file) throw std::runtime_error("Cannot open output file: " + output_path);
+        }
+        std::ostream &os = output_path.empty() ? std::cout : file;
+
+        if (format == output_format::json) {
+            os << "[\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                const auto &r = results[i];
+                os << "  {\"family\": \"" << json_escape(r.family) << "\""
+                        << ", \"section\": \"" << json_escape(r.section) << "\""
+                        << ", \"variant\": \"" << json_escape(r.variant) << "\""
+                        << ", \"device\": \"" << json_escape(r.device) << "\""
+                        << ", \"shape\": \"" << json_escape(r.shape) << "\""
+                        << ", \"status\": \"" << json_escape(r.status) << "\""
+                        << ", \"iterations\": " << r.iterations
+                        << ", \"avg_ms\": " << r.avg_ms
+                        << ", \"min_ms\": " << r.min_ms
+                        << ", \"gbps\": " << r.gbps
+                        << ", \"gflops\": " << r.gflops
+                        << ", \"speedup\": " << r.speedup
+                        << ", \"device_ms\": " << r.device_ms
+                        << ", \"host_ms\": " << r.host_ms
+                        << ", \"intensity\": " << r.intensity
+                        << ", \"roof_pct\": " << r.roof_pct
+                        << ", \"bound\": \"" << r.bound << "\""
+                        << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+            os << "]\n";
+        } else {
+            os << "family,section,variant,device,shape,status,iterations,avg_ms,min_ms,gbps,gflops,speedup,"
+                    "device_ms,host_ms,intensity,roof_pct,bound\n";
+            for (const auto &r: results) {
+                os << csv_escape(r.family) << "," << csv_escape(r.section) << "," << csv_escape(r.variant) << ","
+                        << csv_escape(r.device) << "," << csv_escape(r.shape) << "," << csv_escape(r.status) << ","
+                        << r.iterations << "," << r.avg_ms << "," << r.min_ms << ","
+                        << r.gbps << "," << r.gflops << "," << r.speedup << ","
+                        << r.device_ms << "," << r.host_ms << ","
+                        << r.intensity << "," << r.roof_pct << "," << r.bound << "\n";
+            }
+        }
+    }
+
+    void print_help() const {
+        std::cout << "Usage: " << family << " [options]\n"
+                << "  --device=<gpu|cpu|acc|default|index|name>  device to run on (default gpu)\n"
+                << "  --secs=<seconds>                           time budget per variant (default 10)\n"
+                << "  --filter=<a,b,...>                         only run variants containing one of the substrings\n"
+                << "  --format=<text|json|csv>                   result format (default text)\n"
+                << "  --output=<path>                            write json/csv results to a file\n"
+                << "  --graph                                    also time recorded graph replays of the variants\n"
+                << "  --profiling=0                              wall-clock times only, no device timestamps\n"
+                << "  --roofline                                 report intensity, % of roof and bound per variant\n"
+                << "  --peak_gbps=<x> --peak_gflops=<x>          device peaks to use instead of measuring them\n"
+                << "  --<key>=<value>                            problem sizes, e.g. --size=64M --m=1000\n"
+                << "  --list-devices                             print all devices and exit\n";
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+
+// Record a fixed sequence of submissions once and replay it as a whole.
+//
+// Multi-kernel sequences (a single_task init before the main kernel, one launch per level of a
+// recursive reduction, ...) pay the host submission cost of every command on every call. A
+// Recording captures what submit(q) enqueues into a sycl_ext_oneapi_graph command graph, finalizes
+// it once and replay() then submits the whole graph with one call. Pointers and sizes are frozen at
+// recording time, and pool temporaries freed during the recording stay reserved for the replays.
+//
+// Without the extension, on a device without graph support, or when submit() cannot be recorded
+// (e.g. it waits on the host), replay() falls back to calling submit(q) again.
+
+namespace bench {
+
+class Recording {
+public:
+    Recording(sycl::queue &q, std::function<void(sycl::queue &)> submit) : q(q), submit(std::move(submit)) {
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+        namespace syclex = sycl::ext::oneapi::experimental;
+        if (!q.get_device().has(sycl::aspect::ext_oneapi_limited_graph)) return;
+
+        syclex::command_graph<syclex::graph_state::modifiable> graph{q.get_context(), q.get_device()};
+        usm_pool().defer_frees(&held);
+        try {
+            graph.begin_recording(q);
+            this->submit(q);
+            graph.end_recording(q);
+            sycl::property_list props;
+            if (q.has_property<sycl::property::queue::enable_profiling>()) {
+                props = {syclex::property::graph::enable_profiling()}; // replay events keep device timestamps
+            }
+            exec = std::make_unique<syclex::command_graph<syclex::graph_state::executable> >(graph.finalize(props));
+        } catch (const sycl::exception &) {
+            graph.end_recording(q);
+        } catch (...) {
+            // not a recording failure: the destructor will not run, so undo everything here before rethrowing
+            graph.end_recording(q);
+            usm_pool().defer_frees(nullptr);
+            release_held();
+            throw;
+        }
+        usm_pool().defer_frees(nullptr);
+#endif
+    }
+
+    Recording(const Recording &) = delete;
+    Recording &operator=(const Recording &) = delete;
+
+    ~Recording() {
+        release_held();
+    }
+
+    bool recorded() const {
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+        return exec != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    // Submit the recorded sequence again; does not wait.
+    void replay() {
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+        if (exec) {
+            track(q.ext_oneapi_graph(*exec));
+            return;
+        }
+#endif
+        submit(q);
+    }
+
+private:
+    void release_held() {
+        q.wait();
+        for (void *ptr: held) {
+            usm_pool().free(ptr, q);
+        }
+        held.clear();
+    }
+
+    sycl::queue q;
+    std::function<void(sycl::queue &)> submit;
+    std::vector<void *> held; // pool blocks freed while recording
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+    std::unique_ptr<sycl::ext::oneapi::experimental::command_graph<
+        sycl::ext::oneapi::experimental::graph_state::executable> > exec;
+#endif
+};
+
+} // namespace bench
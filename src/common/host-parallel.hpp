@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Multi-threaded host loops for the *_ref implementations, so the CPU baselines use every core.
+//
+// A process-wide pool of host_threads() - 1 workers plus the calling thread runs the blocks of
+// host_parallel_for() / host_parallel_reduce(). LEARN_SYCL_HOST_THREADS overrides the thread count,
+// 1 gives serial references. Blocks are contiguous so their inner loops vectorize; host_simd_sum()
+// keeps independent partial sums so reductions vectorize too without -ffast-math.
+
+namespace bench {
+
+inline size_t host_threads() {
+    static size_t threads = [] {
+        if (const char *env = std::getenv("LEARN_SYCL_HOST_THREADS")) {
+            return std::max<size_t>(std::strtoul(env, nullptr, 10), 1);
+        }
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }();
+    return threads;
+}
+
+class HostPool {
+public:
+    explicit HostPool(size_t threads) {
+        for (size_t t = 1; t < threads; t++) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    HostPool(const HostPool &) = delete;
+    HostPool &operator=(const HostPool &) = delete;
+
+    ~HostPool() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &worker: workers) {
+            worker.join();
+        }
+    }
+
+    // Runs task(i) for every i in [0, tasks) and returns when all are done; the calling thread takes part.
+    // Must not be called from inside a task.
+    void run(size_t tasks, const std::function<void(size_t)> &task) {
+        if (workers.empty() || tasks <= 1) {
+            for (size_t i = 0; i < tasks; i++) task(i);
+            return;
+        }
+        std::lock_guard run_lock{run_mutex};
+        Job job{&task, tasks};
+        {
+            std::lock_guard lock{mutex};
+            current = &job;
+            generation++;
+        }
+        wake.notify_all();
+        execute(job);
+
+        // workers still inside execute() hold a pointer to job
+        std::unique_lock lock{mutex};
+        done.wait(lock, [&] { return job.done == tasks && active == 0; });
+        current = nullptr;
+    }
+
+private:
+    struct Job {
+        const std::function<void(size_t)> *task;
+        size_t tasks;
+        std::atomic<size_t> next{0}, done{0};
+    };
+
+    void execute(Job &job) {
+        for (size_t i; (i = job.next++) < job.tasks;) {
+            (*job.task)(i);
+            if (++job.done == job.tasks) {
+                std::lock_guard lock{mutex};
+                done.notify_all();
+            }
+        }
+    }
+
+    void work() {
+        size_t seen = 0;
+        while (true) {
+            Job *job;
+            {
+                std::unique_lock lock{mutex};
+                wake.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+                job = current;
+                if (!job) continue;
+                active++;
+            }
+            execute(*job);
+            {
+                std::lock_guard lock{mutex};
+                active--;
+            }
+            done.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex, mutex;
+    std::condition_variable wake, done;
+    Job *current = nullptr;
+    size_t generation = 0, active = 0;
+    bool stop = false;
+};
+
+inline HostPool &host_pool() {
+    static HostPool pool{host_threads()};
+    return pool;
+}
+
+// Splits [0, size) into blocks of at least min_block items, about 4 per thread so uneven blocks balance out.
+inline size_t host_block_size(size_t size, size_t min_block) {
+    size_t blocks = std::clamp<size_t>(size / std::max<size_t>(min_block, 1), 1, host_threads() * 4);
+    return std::max<size_t>((size + blocks - 1) / blocks, 1);
+}
+
+// f(begin, end) for every block of [0, size).
+template<typename F>
+void host_parallel_for(size_t size, F &&f, size_t min_block = 4096) {
+    size_t block = host_block_size(size, min_block);
+    host_pool().run((size + block - 1) / block, [&](size_t b) {
+        f(b * block, std::min((b + 1) * block, size));
+    });
+}
+
+// combine(init, f(block 0), f(block 1), ...), folded in block order so the result does not depend on timing.
+template<typename T, typename F, typename Combine = std::plus<> >
+T host_parallel_reduce(size_t size, T init, F &&f, Combine combine = {}, size_t min_block = 4096) {
+    size_t block = host_block_size(size, min_block);
+    std::vector<T> partial((size + block - 1) / block, init);
+    host_pool().run(partial.size(), [&](size_t b) {
+        partial[b] = f(b * block, std::min((b + 1) * block, size));
+    });
+    for (const T &p: partial) {
+        init = combine(init, p);
+    }
+    return init;
+}
+
+// Sum of x(i) over [begin, end) in LANES independent accumulators.
+template<typename Acc, size_t LANES = 8, typename X>
+Acc host_simd_sum(size_t begin, size_t end, X &&x) {
+    Acc acc[LANES] = {};
+    size_t i = begin;
+    for (; i + LANES <= end; i += LANES) {
+        for (size_t l = 0; l < LANES; l++) {
+            acc[l] += x(i + l);
+        }
+    }
+    Acc sum{};
+    for (size_t l = 0; l < LANES; l++) {
+        sum += acc[l];
+    }
+    for (; i < end; i++) {
+        sum += x(i);
+    }
+    return sum;
+}
+
+} // namespace bench
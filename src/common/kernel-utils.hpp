@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+// Launch helpers for problem sizes that are not multiples of the work-group tile:
+// the nd_range is rounded up and the kernels mask or peel the out-of-range part.
+
+constexpr size_t ceil_div(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+constexpr size_t round_up(size_t a, size_t b) {
+    return ceil_div(a, b) * b;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+
+// Row-partitioned execution of one operator over several devices.
+//
+// The operator is out[rows, out_cols] = f(in[rows, in_cols], shared) with row-major in/out, which covers
+// GEMM (in = A, shared = B, out = C) and row-major GEMV (in = A, shared = b, out = c). The rows are split
+// across the queues in proportion to each device's measured throughput; every device gets its own
+// copies of its slice and of the shared operand, runs the kernel, and copies its slice of out back
+// to the host, all devices concurrently. Devices need not share a context.
+
+namespace bench {
+
+// Split a device into `parts` sub-devices of (nearly) equal compute units, e.g. a CPU into NUMA-sized
+// pieces, so the partitioning can be exercised on a single machine. Throws when the device cannot be
+// partitioned.
+inline std::vector<sycl::device> split_device(const sycl::device &device, size_t parts) {
+    using sycl::info::partition_property;
+    size_t cu = device.get_info<sycl::info::device::max_compute_units>();
+    if (parts < 2 || cu < parts) {
+        throw std::invalid_argument("Cannot split a device with " + std::to_string(cu) + " compute units into "
+                                    + std::to_string(parts) + " parts");
+    }
+
+    // partition_equally(cu / parts) can return more than parts sub-devices (10 CUs in 4 parts gives 5):
+    // give the remainder to the first sub-devices by counts, or drop the extra ones where only equal
+    // partitioning is supported.
+    auto supported = device.get_info<sycl::info::device::partition_properties>();
+    std::vector<sycl::device> sub_devices;
+    if (std::find(supported.begin(), supported.end(), partition_property::partition_by_counts) != supported.end()) {
+        std::vector<size_t> counts(parts, cu / parts);
+        for (size_t i = 0; i < cu % parts; i++) {
+            counts[i]++;
+        }
+        sub_devices = device.create_sub_devices<partition_property::partition_by_counts>(counts);
+    } else {
+        sub_devices = device.create_sub_devices<partition_property::partition_equally>(cu / parts);
+        if (sub_devices.size() > parts) sub_devices.resize(parts);
+    }
+    if (sub_devices.size() != parts) {
+        throw std::runtime_error("Splitting the device returned " + std::to_string(sub_devices.size())
+                                 + " sub-devices, expected " + std::to_string(parts));
+    }
+    return sub_devices;
+}
+
+inline std::vector<sycl::queue> make_queues(const std::vector<sycl::device> &devices, const sycl::queue &like) {
+    std::vector<sycl::queue> queues;
+    for (const auto &device: devices) {
+        queues.emplace_back(device, in_order_like(like));
+    }
+    return queues;
+}
+
+template<typename T>
+class RowPartitioner {
+public:
+    // kernel(q, in, shared, out, rows) on device pointers
+    using kernel_t = std::function<void(sycl::queue &, T *, T *, T *, size_t)>;
+
+    RowPartitioner(std::vector<sycl::queue> queues, size_t in_cols, size_t shared_size, size_t out_cols,
+                   size_t row_align = 16)
+        : queues(std::move(queues)), in_cols(in_cols), shared_size(shared_size), out_cols(out_cols),
+          row_align(row_align), weights(this->queues.size(), 1.0) {
+        if (this->queues.empty()) throw std::invalid_argument("RowPartitioner needs at least one queue");
+    }
+
+    size_t size() const { return queues.size(); }
+    sycl::queue &queue(size_t i) { return queues[i]; }
+    const std::vector<double> &throughput() const { return weights; }
+
+    // Time every device alone on probe_rows rows, transfers included, and use rows/s as its weight.
+    // A device that cannot run the kernel (e.g. unsupported sub-group size) gets weight 0.
+    void calibrate(const kernel_t &kernel, const T *in, const T *shared, size_t probe_rows, size_t reps = 3,
+                   std::ostream *log = nullptr) {
+        std::vector<T> out(probe_rows * out_cols);
+        for (size_t i = 0; i < queues.size(); i++) {
+            try {
+                run_slice(i, kernel, in, shared, out.data(), probe_rows); // warm up, JIT
+                queues[i].wait();
+                auto start = std::chrono::steady_clock::now();
+                for (size_t r = 0; r < reps; r++) {
+                    run_slice(i, kernel, in, shared, out.data(), probe_rows);
+                    queues[i].wait();
+                }
+                double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                weights[i] = probe_rows * reps / secs;
+            } catch (const std::exception &e) {
+                weights[i] = 0;
+                if (log) *log << "\t" << device_name(i) << " excluded: " << e.what() << "\n";
+            }
+        }
+        if (std::all_of(weights.begin(), weights.end(), [](double w) { return w == 0; })) {
+            throw std::runtime_error("RowPartitioner: no device can run the kernel");
+        }
+    }
+
+    void set_throughput(std::vector<double> w) {
+        if (w.size() != queues.size()) throw std::invalid_argument("one weight per queue expected");
+        weights = std::move(w);
+    }
+
+    // Rows per device, proportional to the weights and rounded to row_align; the rest goes to the
+    // fastest device.
+    std::vector<size_t> split(size_t rows) const {
+        double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+        std::vector<size_t> parts(queues.size(), 0);
+        size_t assigned = 0;
+        for (size_t i = 0; i < queues.size(); i++) {
+            size_t share = static_cast<size_t>(rows * weights[i] / total) / row_align * row_align;
+            parts[i] = std::min(share, rows - assigned);
+            assigned += parts[i];
+        }
+        size_t fastest = std::max_element(weights.begin(), weights.end()) - weights.begin();
+        parts[fastest] += rows - assigned;
+        return parts;
+    }
+
+    // out = f(in, shared) over all rows, host pointers in and out. Blocks until out is complete.
+    void run(const kernel_t &kernel, const T *in, const T *shared, T *out, size_t rows) {
+        std::vector<size_t> parts = split(rows);
+        for (size_t i = 0, first = 0; i < queues.size(); first += parts[i], i++) {
+            if (parts[i] == 0) continue;
+            run_slice(i, kernel, in + first * in_cols, shared, out + first * out_cols, parts[i]);
+        }
+        for (auto &q: queues) {
+            q.wait();
+        }
+    }
+
+    std::string device_name(size_t i) const {
+        return queues[i].get_device().get_info<sycl::info::device::name>();
+    }
+
+private:
+    std::vector<sycl::queue> queues;
+    size_t in_cols, shared_size, out_cols, row_align;
+    std::vector<double> weights;
+
+    // Submits copy-in, kernel and copy-out of one slice to queue i without waiting.
+    void run_slice(size_t i, const kernel_t &kernel, const T *in, const T *shared, T *out, size_t rows) {
+        sycl::queue &q = queues[i];
+        EventLog::DeviceScope scope{event_log(), q.get_device()};
+        auto &pool = usm_pool();
+        T *d_in = pool.malloc_device<T>(rows * in_cols, q);
+        T *d_shared = pool.malloc_device<T>(shared_size, q);
+        T *d_out = pool.malloc_device<T>(rows * out_cols, q);
+        track(q.memcpy(d_in, in, rows * in_cols * sizeof(T)));
+        track(q.memcpy(d_shared, shared, shared_size * sizeof(T)));
+        kernel(q, d_in, d_shared, d_out, rows);
+        track(q.memcpy(out, d_out, rows * out_cols * sizeof(T)));
+        // in-order queue: the blocks are reused only after the copy-out
+        pool.free(d_in, q);
+        pool.free(d_shared, q);
+        pool.free(d_out, q);
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+// Device-side timing of the commands a benchmark variant submits.
+//
+// The driver's host clock around `func(); q.wait()` also counts submission, runtime bookkeeping and
+// the wait itself. Kernels pass the events of their submissions through track(); while the driver
+// times an iteration the event log keeps them, and afterwards reads command_start/command_end from
+// each. The device time of the iteration is the length of the union of those intervals, so commands
+// that overlap (copy and compute queues) count once. Outside a timed iteration track() only forwards
+// the event.
+//
+// The queues must be created with sycl::property::queue::enable_profiling. Timestamps are only compared
+// within one root device: code that submits to queues of other devices (common/multi-device.hpp) tags
+// its events with a DeviceScope, and an iteration whose events span several root devices, or where any
+// event lacks profiling information, reports no device time rather than a wrong one.
+
+namespace bench {
+
+// The device a sub-device was split from, or the device itself; sub-devices share its clock.
+inline sycl::device root_device(sycl::device device) {
+    while (true) {
+        try {
+            device = device.get_info<sycl::info::device::parent_device>();
+        } catch (const sycl::exception &) {
+            return device;
+        }
+    }
+}
+
+class EventLog {
+public:
+    void start() {
+        events.clear();
+        active = true;
+    }
+
+    // Stops collecting and returns the device time of the events tracked since start(), in ms, or a
+    // negative value when there is none to report: no events, an event without profiling information,
+    // or events from more than one root device. The events must be complete.
+    double stop_ms() {
+        active = false;
+        std::vector<std::pair<uint64_t, uint64_t> > spans;
+        std::optional<sycl::device> root;
+        bool untagged = false, valid = true;
+        for (const auto &[e, tagged]: events) {
+            if (tagged) {
+                sycl::device r = root_device(*tagged);
+                if (untagged || (root && *root != r)) valid = false;
+                root = r;
+            } else {
+                if (root) valid = false;
+                untagged = true;
+            }
+            try {
+                spans.emplace_back(e.get_profiling_info<sycl::info::event_profiling::command_start>(),
+                                   e.get_profiling_info<sycl::info::event_profiling::command_end>());
+            } catch (const sycl::exception &) {
+                // queue without enable_profiling, or a command the backend does not profile: a partial
+                // sum would undercount the iteration
+                valid = false;
+            }
+        }
+        events.clear();
+        if (!valid || spans.empty()) return -1;
+
+        std::sort(spans.begin(), spans.end());
+        uint64_t busy_ns = 0;
+        uint64_t begin = spans[0].first, end = spans[0].second;
+        for (const auto &[s, e]: spans) {
+            if (s > end) {
+                busy_ns += end - begin;
+                begin = s;
+            }
+            end = std::max(end, e);
+        }
+        busy_ns += end - begin;
+        return static_cast<double>(busy_ns) * 1e-6;
+    }
+
+    sycl::event track(sycl::event e) {
+        if (active) events.emplace_back(e, device);
+        return e;
+    }
+
+    // While alive, tracked events are attributed to `d` instead of the driver's device.
+    class DeviceScope {
+    public:
+        DeviceScope(EventLog &log, const sycl::device &d) : log(log), previous(std::exchange(log.device, d)) {}
+        DeviceScope(const DeviceScope &) = delete;
+        DeviceScope &operator=(const DeviceScope &) = delete;
+        ~DeviceScope() { log.device = previous; }
+
+    private:
+        EventLog &log;
+        std::optional<sycl::device> previous;
+    };
+
+private:
+    std::vector<std::pair<sycl::event, std::optional<sycl::device> > > events;
+    std::optional<sycl::device> device; // empty: the driver's device
+    bool active = false;
+};
+
+inline EventLog &event_log() {
+    static thread_local EventLog log;
+    return log;
+}
+
+// Properties for an extra in-order queue next to `like`, profiling when `like` does.
+inline sycl::property_list in_order_like(const sycl::queue &like) {
+    if (like.has_property<sycl::property::queue::enable_profiling>()) {
+        return {sycl::property::queue::in_order(), sycl::property::queue::enable_profiling()};
+    }
+    return {sycl::property::queue::in_order()};
+}
+
+// Wrap a submission, e.g. bench::track(q.parallel_for(...)), to include it in the device time.
+inline sycl::event track(sycl::event e) {
+    return event_log().track(std::move(e));
+}
+
+} // namespace bench
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <string>
+#include <sycl/sycl.hpp>
+
+#include "common/kernel-utils.hpp"
+#include "common/profiling.hpp"
+#include "common/usm-pool.hpp"
+
+// Roofline model of a device: a kernel with arithmetic intensity I (flop per byte of memory traffic)
+// can reach at most min(peak_gflops, I * peak_gbps). Below the ridge point peak_gflops / peak_gbps it
+// is memory-bound, above it compute-bound.
+//
+// The peaks are measured rather than taken from a datasheet: bandwidth with the copy kernels below (also
+// vector-copy's naive and with_vec variants) on buffers far larger than the caches, FP32 throughput with a
+// kernel of independent FMA chains.
+
+namespace bench {
+
+struct Roof {
+    double gbps = 0; // peak memory bandwidth, GB/s
+    double gflops = 0; // peak FP32 FMA throughput, GFLOP/s
+
+    double ridge() const { return gflops / gbps; }
+};
+
+struct RooflinePoint {
+    double intensity = 0; // flop/byte, 0 for pure data movement
+    double roof_pct = 0; // achieved / attainable at this intensity
+    bool compute_bound = false;
+};
+
+// Place a result on the roof; achieved_gbps/gflops are derived from the same time.
+inline RooflinePoint classify(const Roof &roof, size_t bytes, size_t flop, double achieved_gbps,
+                              double achieved_gflops) {
+    RooflinePoint p;
+    if (bytes == 0) {
+        p.compute_bound = true;
+        p.roof_pct = 100 * achieved_gflops / roof.gflops;
+        return p;
+    }
+    p.intensity = static_cast<double>(flop) / static_cast<double>(bytes);
+    p.compute_bound = p.intensity >= roof.ridge();
+    p.roof_pct = flop == 0
+                     ? 100 * achieved_gbps / roof.gbps
+                     : 100 * achieved_gflops / std::min(roof.gflops, p.intensity * roof.gbps);
+    return p;
+}
+
+// Best of reps runs of submit(), in ms: device time when the queue profiles, wall-clock otherwise.
+inline double time_best_ms(sycl::queue &q, const std::function<void()> &submit, size_t reps = 5) {
+    submit(); // warm up, JIT
+    q.wait();
+    double best = std::numeric_limits<double>::max();
+    for (size_t r = 0; r < reps; r++) {
+        event_log().start();
+        auto start = std::chrono::steady_clock::now();
+        submit();
+        q.wait();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        double device_ms = event_log().stop_ms();
+        best = std::min(best, device_ms > 0 ? device_ms : ms);
+    }
+    return best;
+}
+
+// out = src, one element per work-item.
+template<typename T>
+void copy_naive(sycl::queue &q, T *src, T *out, size_t size) {
+    track(q.parallel_for({size}, [=](sycl::id<1> idx) {
+        size_t offset = idx.get(0);
+        out[offset] = src[offset];
+    }));
+}
+
+// out = src, WI_SIZE elements per work-item as one sycl::vec load/store, scalar tail in the edge work-group.
+template<
+    typename T,
+    size_t WG_SIZE,
+    size_t SG_SIZE,
+    size_t WI_SIZE
+>
+void copy_with_vec(sycl::queue &q, T *src, T *out, size_t size) {
+    track(q.parallel_for(
+        sycl::nd_range<1>{round_up(ceil_div(size, WI_SIZE), WG_SIZE), WG_SIZE},
+        [=](sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(SG_SIZE)]] {
+            size_t i = item.get_global_linear_id();
+            if ((i + 1) * WI_SIZE <= size) {
+                sycl::vec<T, WI_SIZE> vec;
+                vec.load(i, src);
+                vec.store(i, out);
+            } else {
+                for (size_t j = i * WI_SIZE; j < size; j++) {
+                    out[j] = src[j];
+                }
+            }
+        }));
+}
+
+// Copy bandwidth (read + write) on two buffers of `bytes` each.
+inline double measure_peak_gbps(sycl::queue &q, size_t bytes = 256 * 1024 * 1024) {
+    size_t max_alloc = q.get_device().get_info<sycl::info::device::max_mem_alloc_size>();
+    size_t size = std::min(bytes, max_alloc) / sizeof(float);
+    auto &pool = usm_pool();
+    float *src = pool.malloc_device<float>(size, q);
+    float *dst = pool.malloc_device<float>(size, q);
+    q.fill(src, 1.0f, size).wait();
+
+    double ms;
+    try {
+        ms = time_best_ms(q, [&] { copy_with_vec<float, 256, 16, 4>(q, src, dst, size); });
+    } catch (const sycl::exception &) {
+        // sub-group size 16 unsupported
+        ms = time_best_ms(q, [&] { copy_naive<float>(q, src, dst, size); });
+    }
+    pool.free(src, q);
+    pool.free(dst, q);
+    return 2.0 * size * sizeof(float) / (ms * 1e6);
+}
+
+// CHAINS independent FMA chains per work-item hide the FMA latency; the result is stored only when it
+// matches an impossible value so the compiler cannot drop the chains.
+template<size_t CHAINS = 16, size_t ITERS = 1024>
+void fma_peak_kernel(sycl::queue &q, float *out, size_t items, float a, float b) {
+    constexpr size_t wg_size = 256;
+    track(q.parallel_for(
+        sycl::nd_range<1>{round_up(items, wg_size), wg_size},
+        [=](sycl::nd_item<1> item) {
+            float x[CHAINS];
+#pragma unroll
+            for (size_t c = 0; c < CHAINS; c++) {
+                x[c] = static_cast<float>(item.get_global_linear_id() + c);
+            }
+            for (size_t i = 0; i < ITERS; i++) {
+#pragma unroll
+                for (size_t c = 0; c < CHAINS; c++) {
+                    x[c] = sycl::fma(x[c], a, b);
+                }
+            }
+            float sum = 0;
+#pragma unroll
+            for (size_t c = 0; c < CHAINS; c++) {
+                sum += x[c];
+            }
+            if (sum == -1.0f) out[0] = sum;
+        }));
+}
+
+inline double measure_peak_gflops(sycl::queue &q) {
+    constexpr size_t chains = 16, iters = 1024;
+    size_t cu = q.get_device().get_info<sycl::info::device::max_compute_units>();
+    size_t items = round_up(cu * 1024, 256);
+    float *out = usm_pool().malloc_device<float>(1, q);
+    double ms = time_best_ms(q, [&] { fma_peak_kernel<chains, iters>(q, out, items, 0.999f, 0.001f); });
+    usm_pool().free(out, q);
+    return 2.0 * items * chains * iters / (ms * 1e6);
+}
+
+inline Roof measure_roof(sycl::queue &q) {
+    return {measure_peak_gbps(q), measure_peak_gflops(q)};
+}
+
+} // namespace bench
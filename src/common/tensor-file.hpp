@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sycl/sycl.hpp>
+
+#include "common/usm-pool.hpp"
+#include "cpp-bench-utils/utils.hpp"
+
+// Binary container for benchmark inputs, so a real matrix can be replayed instead of random_fill.
+//
+//   [0, 64)             TensorHeader, little endian
+//   [data_offset, ...)  elements, line after line (rows for row-major, columns for col-major), ld apart
+//
+// data_offset is page aligned, so the data can be used in place from an mmap of the file: handed to
+// q.memcpy directly, registered with the runtime for faster copies, or copied into USM host memory
+// without going through a std::vector. Mapping is lazy, pages are read from disk on first touch;
+// page_in() forces that up front so it can be timed apart from the transfers and kernels.
+//
+// A vector is stored as rank 1 with rows = size and cols = 1.
+
+namespace bench {
+
+enum class tensor_dtype : uint32_t {
+    f32 = 1,
+    f64 = 2,
+    i8 = 3,
+    i32 = 4,
+    u32 = 5,
+};
+
+// Bytes per element, 0 for a value that is not a tensor_dtype.
+inline size_t tensor_dtype_size(tensor_dtype dtype) {
+    switch (dtype) {
+        case tensor_dtype::f32: return 4;
+        case tensor_dtype::f64: return 8;
+        case tensor_dtype::i8: return 1;
+        case tensor_dtype::i32: return 4;
+        case tensor_dtype::u32: return 4;
+        default: return 0;
+    }
+}
+
+template<typename T>
+constexpr tensor_dtype tensor_dtype_of() {
+    if constexpr (std::is_same_v<T, float>) return tensor_dtype::f32;
+    else if constexpr (std::is_same_v<T, double>) return tensor_dtype::f64;
+    else if constexpr (std::is_same_v<T, int8_t>) return tensor_dtype::i8;
+    else if constexpr (std::is_same_v<T, int32_t>) return tensor_dtype::i32;
+    else if constexpr (std::is_same_v<T, uint32_t>) return tensor_dtype::u32;
+    else static_assert(!sizeof(T), "unsupported tensor element type");
+}
+
+struct TensorHeader {
+    char magic[8]; // "LSYCLTNS"
+    uint32_t version;
+    tensor_dtype dtype;
+    uint32_t rank; // 1 for vectors, 2 for matrices
+    uint32_t col_major; // 0 row-major, 1 col-major
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t ld; // elements between the starts of two lines
+    uint64_t data_offset;
+    uint64_t data_bytes;
+};
+
+static_assert(sizeof(TensorHeader) == 64);
+
+inline constexpr char tensor_magic[8] = {'L', 'S', 'Y', 'C', 'L', 'T', 'N', 'S'};
+inline constexpr uint32_t tensor_version = 1;
+inline constexpr uint64_t tensor_data_align = 4096;
+
+namespace tensor_detail {
+    template<typename T>
+    void write(const std::string &path, const T *data, uint32_t rank, size_t rows, size_t cols,
+               cbu::matrix_layout layout, size_t ld) {
+        bool col_major = layout == cbu::matrix_layout::col_major;
+        size_t lines = col_major ? cols : rows;
+        size_t line_size = col_major ? rows : cols;
+        ld = ld ? ld : line_size;
+        if (ld < line_size) {
+            throw std::invalid_argument("write_tensor_file: ld is smaller than a line");
+        }
+
+        TensorHeader header{};
+        std::memcpy(header.magic, tensor_magic, sizeof(header.magic));
+        header.version = tensor_version;
+        header.dtype = tensor_dtype_of<T>();
+        header.rank = rank;
+        header.col_major = col_major;
+        header.rows = rows;
+        header.cols = cols;
+        header.ld = ld;
+        header.data_offset = tensor_data_align;
+        header.data_bytes = lines * ld * sizeof(T);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("Cannot open tensor file for writing: " + path);
+        std::vector<char> pad(header.data_offset - sizeof(header), 0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(pad.data(), pad.size());
+        file.write(reinterpret_cast<const char *>(data), header.data_bytes);
+        if (!file) throw std::runtime_error("Failed to write tensor file: " + path);
+    }
+}
+
+// Write a rows x cols matrix (rank 2, also when cols is 1) with leading dimension ld (0 means packed).
+template<typename T>
+void write_tensor_file(const std::string &path, const T *data, size_t rows, size_t cols,
+                       cbu::matrix_layout layout = cbu::matrix_layout::row_major, size_t ld = 0) {
+    tensor_detail::write(path, data, 2, rows, cols, layout, ld);
+}
+
+// Write a vector (rank 1).
+template<typename T>
+void write_tensor_file(const std::string &path, const std::vector<T> &vec) {
+    tensor_detail::write(path, vec.data(), 1, vec.size(), 1, cbu::matrix_layout::row_major, 0);
+}
+
+// Read-only view of a tensor file through mmap. The mapping is private, so data<T>() can be handed to
+// APIs that take a non-const pointer; writes never reach the file.
+class MappedTensor {
+public:
+    explicit MappedTensor(const std::string &path) : path(path) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open tensor file: " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TensorHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Not a tensor file: " + path);
+        }
+        mapped_bytes = st.st_size;
+        void *ptr = ::mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("mmap failed: " + path);
+        }
+        base = static_cast<char *>(ptr);
+        std::memcpy(&hdr, base, sizeof(hdr));
+
+        if (std::memcmp(hdr.magic, tensor_magic, sizeof(hdr.magic)) != 0 || hdr.version != tensor_version) {
+            unmap();
+            throw std::runtime_error("Not a tensor file: " + path);
+        }
+        if (const char *error = validate(hdr, mapped_bytes)) {
+            unmap();
+            throw std::runtime_error("Invalid tensor file " + path + ": " + error);
+        }
+    }
+
+    MappedTensor(const MappedTensor &) = delete;
+    MappedTensor &operator=(const MappedTensor &) = delete;
+
+    MappedTensor(MappedTensor &&other) noexcept { *this = std::move(other); }
+
+    MappedTensor &operator=(MappedTensor &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            path = std::move(other.path);
+            hdr = other.hdr;
+            fd = std::exchange(other.fd, -1);
+            base = std::exchange(other.base, nullptr);
+            mapped_bytes = std::exchange(other.mapped_bytes, 0);
+            registered_queue = std::move(other.registered_queue);
+            other.registered_queue.clear();
+        }
+        return *this;
+    }
+
+    ~MappedTensor() {
+        unmap();
+    }
+
+    const TensorHeader &header() const { return hdr; }
+    size_t rows() const { return hdr.rows; }
+    size_t cols() const { return hdr.cols; }
+    size_t ld() const { return hdr.ld; }
+    size_t size() const { return hdr.rows * hdr.cols; }
+    size_t data_bytes() const { return hdr.data_bytes; }
+
+    cbu::matrix_layout layout() const {
+        return hdr.col_major ? cbu::matrix_layout::col_major : cbu::matrix_layout::row_major;
+    }
+
+    bool packed() const {
+        return hdr.ld == (hdr.col_major ? hdr.rows : hdr.cols);
+    }
+
+    // The elements as raw bytes, whatever their type.
+    void *raw_data() const {
+        return base + hdr.data_offset;
+    }
+
+    template<typename T>
+    T *data() const {
+        if (hdr.dtype != tensor_dtype_of<T>()) {
+            throw std::runtime_error("Tensor file " + path + " holds another element type");
+        }
+        return reinterpret_cast<T *>(base + hdr.data_offset);
+    }
+
+    // Fault every page of the data in now, instead of during the first copy or kernel.
+    void page_in() const {
+        char *data = base + hdr.data_offset;
+        ::madvise(data, hdr.data_bytes, MADV_WILLNEED);
+        long page = ::sysconf(_SC_PAGESIZE);
+        volatile char sink = 0;
+        for (size_t i = 0; i < hdr.data_bytes; i += page) {
+            sink = sink + data[i];
+        }
+    }
+
+    // Let the runtime pin the mapped pages so q.memcpy from data<T>() skips the staging copy.
+    // Returns false when the SYCL implementation has no sycl_ext_oneapi_copy_optimize.
+    bool register_for_copy(sycl::queue &q) {
+#ifdef SYCL_EXT_ONEAPI_COPY_OPTIMIZE
+        if (registered_queue.empty()) {
+            sycl::ext::oneapi::experimental::prepare_for_device_copy(base + hdr.data_offset, hdr.data_bytes, q);
+            registered_queue.push_back(q);
+        }
+        return true;
+#else
+        (void) q;
+        return false;
+#endif
+    }
+
+    // Copy the data into USM host memory from the pool, straight from the mapped pages.
+    // Free the result with bench::usm_pool().free(ptr, q).
+    template<typename T>
+    T *stage_to_host(sycl::queue &q) const {
+        T *src = data<T>();
+        T *dst = usm_pool().malloc_host<T>(hdr.data_bytes / sizeof(T), q);
+        std::memcpy(dst, src, hdr.data_bytes);
+        return dst;
+    }
+
+private:
+    std::string path;
+    TensorHeader hdr{};
+
+    // Every size the accessors and data<T>() hand out must lie inside the mapping, so a truncated or
+    // inconsistent header is rejected here rather than read past the end later. Overflow-safe.
+    static const char *validate(const TensorHeader &h, size_t file_bytes) {
+        size_t elem = tensor_dtype_size(h.dtype);
+        if (elem == 0) return "unknown dtype";
+        if (h.rank != 1 && h.rank != 2) return "rank must be 1 or 2";
+        if (h.col_major > 1) return "col_major must be 0 or 1";
+        if (h.rank == 1 && h.cols != 1) return "a rank 1 tensor must have cols == 1";
+        uint64_t lines = h.col_major ? h.cols : h.rows;
+        uint64_t line_size = h.col_major ? h.rows : h.cols;
+        uint64_t elements, data_bytes;
+        if (h.ld < line_size) return "ld is smaller than a line";
+        if (__builtin_mul_overflow(h.rows, h.cols, &elements)
+            || __builtin_mul_overflow(lines, h.ld, &data_bytes)
+            || __builtin_mul_overflow(data_bytes, static_cast<uint64_t>(elem), &data_bytes)) {
+            return "shape overflows";
+        }
+        if (h.data_bytes != data_bytes) return "data_bytes does not match the shape";
+        if (h.data_offset < sizeof(TensorHeader) || h.data_offset % tensor_data_align != 0) {
+            return "data_offset is not page aligned";
+        }
+        if (h.data_offset > file_bytes || h.data_bytes > file_bytes - h.data_offset) return "truncated";
+        return nullptr;
+    }
+
+    int fd = -1;
+    char *base = nullptr;
+    size_t mapped_bytes = 0;
+    std::vector<sycl::queue> registered_queue; // at most one, the queue data was registered with
+
+    void unmap() {
+#ifdef SYCL_EXT_ONEAPI_COPY_OPTIMIZE
+        for (auto &q: registered_queue) {
+            sycl::ext::oneapi::experimental::release_from_device_copy(base + hdr.data_offset, q);
+        }
+#endif
+        registered_queue.clear();
+        if (base) ::munmap(base, mapped_bytes);
+        if (fd >= 0) ::close(fd);
+        base = nullptr;
+        fd = -1;
+    }
+};
+
+} // namespace bench
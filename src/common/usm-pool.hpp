@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sycl/sycl.hpp>
+
+// Caching allocator over sycl::malloc_device / malloc_shared / malloc_host.
+//
+// USM allocation is a synchronous driver call, so kernels and benchmarks take their temporaries from
+// this pool instead. Freed blocks stay cached per (context, device, kind, size class) and are handed
+// out again in queue order:
+//   - on the same in-order queue a device block is reused immediately, later commands run after
+//     every command that used it;
+//   - on another queue (or an out-of-order one) the old queue gets a barrier and the new queue waits
+//     on it with a barrier of its own, so the reuse never blocks the host;
+//   - host and shared blocks can be touched by the host right after allocation, so their barrier
+//     is waited on the host.
+//
+// Sizes up to 1 MiB are rounded up to a power of two, larger ones to a multiple of 1 MiB.
+
+namespace bench {
+
+struct PoolStats {
+    size_t hits = 0; // allocations served from the cache
+    size_t misses = 0; // allocations that went to the driver
+    size_t bytes_in_use = 0;
+    size_t peak_bytes_in_use = 0;
+    size_t bytes_reserved = 0; // in use + cached
+    size_t peak_bytes_reserved = 0;
+};
+
+class UsmPool {
+public:
+    UsmPool() = default;
+    UsmPool(const UsmPool &) = delete;
+    UsmPool &operator=(const UsmPool &) = delete;
+
+    ~UsmPool() {
+        release_cached();
+    }
+
+    template<typename T>
+    T *malloc_device(size_t count, sycl::queue &q) {
+        return static_cast<T *>(allocate(count * sizeof(T), q, sycl::usm::alloc::device));
+    }
+
+    template<typename T>
+    T *malloc_shared(size_t count, sycl::queue &q) {
+        return static_cast<T *>(allocate(count * sizeof(T), q, sycl::usm::alloc::shared));
+    }
+
+    template<typename T>
+    T *malloc_host(size_t count, sycl::queue &q) {
+        return static_cast<T *>(allocate(count * sizeof(T), q, sycl::usm::alloc::host));
+    }
+
+    void *allocate(size_t bytes, sycl::queue &q, sycl::usm::alloc kind) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t block_bytes = size_class(bytes);
+
+        auto &blocks = cached[Key{kind, block_bytes}];
+        for (size_t i = 0; i < blocks.size(); i++) {
+            if (!(blocks[i].queue.get_context() == q.get_context() && blocks[i].queue.get_device() == q.get_device())) {
+                continue;
+            }
+            Block block = blocks[i];
+            blocks.erase(blocks.begin() + i);
+            order_after(block, q);
+            block.queue = q;
+            in_use.emplace(block.ptr, block);
+            counters.hits++;
+            count_use(block_bytes);
+            return block.ptr;
+        }
+
+        void *ptr = sycl::malloc(block_bytes, q, kind);
+        if (!ptr && counters.bytes_reserved > counters.bytes_in_use) {
+            // out of memory, give the cached blocks back and retry once
+            free_cached_locked();
+            ptr = sycl::malloc(block_bytes, q, kind);
+        }
+        if (!ptr) {
+            throw std::runtime_error("USM allocation of " + std::to_string(block_bytes) + " bytes failed");
+        }
+        in_use.emplace(ptr, Block{ptr, block_bytes, kind, q});
+        counters.misses++;
+        counters.bytes_reserved += block_bytes;
+        counters.peak_bytes_reserved = std::max(counters.peak_bytes_reserved, counters.bytes_reserved);
+        count_use(block_bytes);
+        return ptr;
+    }
+
+    // Return a block to the cache. Commands already submitted to q may still use it; the next owner
+    // is ordered after them. nullptr is ignored like std::free.
+    void free(void *ptr, sycl::queue &q) {
+        if (!ptr) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = in_use.find(ptr);
+        if (it == in_use.end()) {
+            throw std::runtime_error("UsmPool::free of a pointer that was not allocated by the pool");
+        }
+        if (deferred) {
+            deferred->push_back(ptr);
+            return;
+        }
+        Block block = it->second;
+        in_use.erase(it);
+        block.queue = q;
+        counters.bytes_in_use -= block.bytes;
+        cached[Key{block.kind, block.bytes}].push_back(block);
+    }
+
+    // While a sink is set, free() parks the blocks in it instead of the cache: a recorded graph keeps
+    // using the temporaries its commands were recorded with. Free them again once the graph is gone.
+    void defer_frees(std::vector<void *> *sink) {
+        std::lock_guard<std::mutex> lock(mutex);
+        deferred = sink;
+    }
+
+    // Wait for the last users of the cached blocks and hand them back to the driver.
+    void release_cached() {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_cached_locked();
+    }
+
+    PoolStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters;
+    }
+
+    void reset_stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.hits = counters.misses = 0;
+        counters.peak_bytes_in_use = counters.bytes_in_use;
+        counters.peak_bytes_reserved = counters.bytes_reserved;
+    }
+
+    void print_stats(std::ostream &os) const {
+        PoolStats s = stats();
+        constexpr double mb = 1024.0 * 1024.0;
+        os << "usm pool: " << s.hits << " hits, " << s.misses << " misses, peak in use "
+                << std::fixed << std::setprecision(1) << s.peak_bytes_in_use / mb << " MB, peak reserved "
+                << s.peak_bytes_reserved / mb << " MB\n" << std::defaultfloat;
+    }
+
+    static size_t size_class(size_t bytes) {
+        constexpr size_t min_bytes = 256, large_bytes = 1 << 20;
+        if (bytes > large_bytes) {
+            return (bytes + large_bytes - 1) / large_bytes * large_bytes;
+        }
+        size_t cls = min_bytes;
+        while (cls < bytes) cls <<= 1;
+        return cls;
+    }
+
+private:
+    struct Block {
+        void *ptr;
+        size_t bytes;
+        sycl::usm::alloc kind;
+        sycl::queue queue; // last queue the block was used on
+    };
+
+    struct Key {
+        sycl::usm::alloc kind;
+        size_t bytes;
+
+        bool operator<(const Key &other) const {
+            return kind != other.kind ? kind < other.kind : bytes < other.bytes;
+        }
+    };
+
+    mutable std::mutex mutex;
+    std::map<Key, std::vector<Block> > cached;
+    std::map<void *, Block> in_use;
+    PoolStats counters;
+    std::vector<void *> *deferred = nullptr;
+
+    void count_use(size_t bytes) {
+        counters.bytes_in_use += bytes;
+        counters.peak_bytes_in_use = std::max(counters.peak_bytes_in_use, counters.bytes_in_use);
+    }
+
+    static void order_after(Block &block, sycl::queue &q) {
+        bool host_visible = block.kind != sycl::usm::alloc::device;
+        if (!host_visible && block.queue == q && q.is_in_order()) return;
+
+        sycl::event released = block.queue.ext_oneapi_submit_barrier();
+        if (host_visible) {
+            released.wait();
+        } else {
+            q.ext_oneapi_submit_barrier({released});
+        }
+    }
+
+    void free_cached_locked() {
+        for (auto &[key, blocks]: cached) {
+            for (auto &block: blocks) {
+                block.queue.wait();
+                sycl::free(block.ptr, block.queue);
+                counters.bytes_reserved -= block.bytes;
+            }
+        }
+        cached.clear();
+    }
+};
+
+// Process wide pool used by the kernels for their temporaries. Intentionally never destroyed:
+// blocks still cached at exit go away with the process instead of racing the SYCL runtime teardown.
+inline UsmPool &usm_pool() {
+    static UsmPool *pool = new UsmPool();
+    return *pool;
+}
+
+} // namespace bench